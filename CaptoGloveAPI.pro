@@ -1,4 +1,4 @@
-QT += core bluetooth
+QT += core bluetooth network
 QT -= gui
 
 # For final version without debug
@@ -11,15 +11,6 @@ CONFIG += qt
 
 TARGET = CaptoGloveAPI
 
-CAPTOGLOVEAPI_LIBRARY {
-    TEMPLATE=lib
-    CONFIG += static
-    DEFINES += CAPTOGLOVEAPI_LIBRARY
-}else{
-    CONFIG += console
-    SOURCES += main.cpp
-}
-
 CONFIG += console
 
 DEFINES += LINUX
@@ -30,12 +21,78 @@ SOURCES = captogloveapi.cpp\
           deviceinfo.cpp \
           serviceinfo.cpp \
           characteristicinfo.cpp \
-          main.cpp
+          characteristicregistry.cpp \
+          listingsnapshot.cpp \
+          sequencetracker.cpp \
+          framesubscriber.cpp \
+          payloadlayout.cpp \
+          calibrationprofile.cpp \
+          handmodel.cpp \
+          autocalibrator.cpp \
+          orientationfilter.cpp \
+          logger.cpp \
+          metricsregistry.cpp \
+          subscriptionmanager.cpp \
+          serviceprofile.cpp \
+          writequeue.cpp \
+          streamwatchdog.cpp \
+          standbylink.cpp \
+          deviceinforeader.cpp \
+          connectiontrace.cpp \
+          sessionrecording.cpp \
+          arrowwriter.cpp \
+          frameexporter.cpp
 
 HEADERS = captogloveapi.h \
           deviceinfo.h \
           serviceinfo.h \
-          characteristicinfo.h
+          characteristicinfo.h \
+          characteristicregistry.h \
+          listingsnapshot.h \
+          fingerframe.h \
+          sequencetracker.h \
+          framesubscriber.h \
+          payloadlayout.h \
+          calibrationprofile.h \
+          handmodel.h \
+          autocalibrator.h \
+          orientationfilter.h \
+          logger.h \
+          metricsregistry.h \
+          subscriptionmanager.h \
+          serviceprofile.h \
+          writequeue.h \
+          streamwatchdog.h \
+          standbylink.h \
+          deviceinforeader.h \
+          connectiontrace.h \
+          sessionrecording.h \
+          arrowwriter.h \
+          frameexporter.h \
+          framering.h \
+          glovestate.h \
+          captogloveuuids.h
+
+# Shared library with the C interface of captoglove_c.h, only that is exported
+CAPTOGLOVEAPI_LIBRARY {
+    TEMPLATE=lib
+    CONFIG += shared
+    DEFINES += CAPTOGLOVEAPI_LIBRARY
+    QMAKE_CXXFLAGS += -fvisibility=hidden
+    SOURCES += captoglove_c.cpp wakeupfd.cpp
+    HEADERS += captoglove_c.h wakeupfd.h
+}else{
+    CONFIG += console
+    SOURCES += main.cpp sessionanalyzer.cpp benchmarks.cpp selfcheck.cpp
+    HEADERS += sessionanalyzer.h benchmarks.h selfcheck.h
+}
+
+# Allocation check of the notification path, run with --alloc-check
+CAPTOGLOVE_ALLOC_CHECK {
+    DEFINES += CAPTOGLOVE_ALLOC_CHECK
+    SOURCES += allocationcheck.cpp
+    HEADERS += allocationcheck.h
+}
 
 # Protobuffer compiler
 message("Generating protocol buffer classes from .proto files.")
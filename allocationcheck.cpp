@@ -0,0 +1,132 @@
+#include "allocationcheck.h"
+#include "captogloveapi.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QThread>
+
+#include <cstdio>
+#include <cstdlib>
+
+// glibc's own entry points, the interposed versions below forward to them
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+}
+
+namespace {
+
+thread_local bool t_armed = false;
+thread_local quint64 t_count = 0;
+thread_local size_t t_firstSize = 0;
+
+inline void track(size_t size)
+{
+    if (!t_armed)
+        return;
+    if (t_count++ == 0)
+        t_firstSize = size;
+}
+
+const int WarmupNotifications = 256;
+const int PayloadVariants = 64;
+const int PayloadSize = 20;
+const unsigned long NotificationSpacingUs = 1000;
+
+}
+
+extern "C" {
+
+void *malloc(size_t size)
+{
+    track(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    track(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    track(size);
+    return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+    track(size);
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    track(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+    track(size);
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr ? 0 : 12;   // ENOMEM
+}
+
+void free(void *ptr)
+{
+    __libc_free(ptr);
+}
+
+}
+
+void AllocationCheck::arm()
+{
+    t_count = 0;
+    t_firstSize = 0;
+    t_armed = true;
+}
+
+quint64 AllocationCheck::disarm()
+{
+    t_armed = false;
+    return t_count;
+}
+
+int AllocationCheck::run(CaptoGloveAPI *api, int notifications)
+{
+    // Payloads exist up front, the Bluetooth backend's receive buffer is outside the guarantee
+    QList<QByteArray> payloads;
+    for (int i = 0; i < PayloadVariants; ++i) {
+        QByteArray payload(PayloadSize, '\0');
+        for (int k = 0; k < PayloadSize; ++k)
+            payload[k] = static_cast<char>((i * 7 + k * 13) & 0xff);
+        payloads.append(payload);
+    }
+
+    // First frames set up the logger ring, trackers and caches
+    for (int i = 0; i < WarmupNotifications; ++i) {
+        api->injectFingerPayload(payloads.at(i % PayloadVariants));
+        QThread::usleep(NotificationSpacingUs);
+    }
+
+    arm();
+    for (int i = 0; i < notifications; ++i) {
+        api->injectFingerPayload(payloads.at(i % PayloadVariants));
+        QThread::usleep(NotificationSpacingUs);
+    }
+    const quint64 count = disarm();
+
+    if (count == 0) {
+        fprintf(stderr, "Allocation check passed: %d notifications without allocation\n", notifications);
+        return 0;
+    }
+
+    fprintf(stderr, "Allocation check FAILED: %llu allocations in %d notifications, first of %zu bytes\n",
+            static_cast<unsigned long long>(count), notifications, t_firstSize);
+    return 1;
+}
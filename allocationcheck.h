@@ -0,0 +1,24 @@
+#ifndef ALLOCATIONCHECK_H
+#define ALLOCATIONCHECK_H
+
+#include <QtGlobal>
+
+class CaptoGloveAPI;
+
+// Allocation tracking for builds with CONFIG += CAPTOGLOVE_ALLOC_CHECK. malloc and
+// friends are interposed for the whole process, only the calling thread's
+// allocations between arm() and disarm() are counted.
+// The notification path has not been through a run yet, until it passes the
+// zero allocation goal stated along the path is unverified.
+namespace AllocationCheck {
+
+void arm();
+quint64 disarm();           // allocations since arm()
+
+// Drives notifications at 1 kHz through the full frame pipeline after a warm
+// up and returns 0 if none of them allocated, the process exit code otherwise
+int run(CaptoGloveAPI *api, int notifications);
+
+}
+
+#endif // ALLOCATIONCHECK_H
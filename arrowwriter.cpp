@@ -0,0 +1,541 @@
+#include "arrowwriter.h"
+#include "logger.h"
+
+#include <QFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+// Sleep of the writer thread while no batch is waiting, a batch fills in seconds
+const std::chrono::milliseconds IdleWait(20);
+
+const char Magic[8] = { 'A', 'R', 'R', 'O', 'W', '1', 0, 0 };
+const quint32 Continuation = 0xFFFFFFFF;
+
+// Values of the Arrow flatbuffer schema (Schema.fbs, Message.fbs, File.fbs)
+const qint16 MetadataV5 = 4;
+const quint8 HeaderSchema = 1;
+const quint8 HeaderRecordBatch = 3;
+const quint8 TypeInt = 2;
+const quint8 TypeFloatingPoint = 3;
+const qint16 PrecisionSingle = 1;
+
+// Builds a flatbuffer back to front, children before the tables referring to them
+class FlatBuilder
+{
+public:
+    int size() const { return static_cast<int>(m_buffer.size()); }
+
+    template <typename T>
+    void push(T value)
+    {
+        align(sizeof(T), sizeof(T));
+        uchar bytes[sizeof(T)];
+        qToLittleEndian<T>(value, bytes);
+        m_buffer.insert(m_buffer.begin(), bytes, bytes + sizeof(T));
+    }
+
+    void pushOffset(int ref)
+    {
+        align(4, 4);
+        push<quint32>(static_cast<quint32>(size() + 4 - ref));
+    }
+
+    int createString(const char *text)
+    {
+        const size_t length = strlen(text);
+        align(length + 1, 4);
+        m_buffer.insert(m_buffer.begin(), 0);
+        m_buffer.insert(m_buffer.begin(), text, text + length);
+        push<quint32>(static_cast<quint32>(length));
+        return size();
+    }
+
+    int createOffsetVector(const std::vector<int> &refs)
+    {
+        align(refs.size() * 4, 4);
+        for (size_t i = refs.size(); i > 0; --i)
+            pushOffset(refs[i - 1]);
+        push<quint32>(static_cast<quint32>(refs.size()));
+        return size();
+    }
+
+    // Structs are passed already laid out, little endian
+    int createStructVector(const std::vector<uchar> &structs, int count, size_t alignment)
+    {
+        align(structs.size(), 4);
+        align(structs.size(), alignment);
+        m_buffer.insert(m_buffer.begin(), structs.begin(), structs.end());
+        push<quint32>(static_cast<quint32>(count));
+        return size();
+    }
+
+    void startTable()
+    {
+        m_fields.clear();
+        m_tableStart = size();
+    }
+
+    template <typename T>
+    void addField(int slot, T value)
+    {
+        push<T>(value);
+        m_fields.push_back(std::make_pair(slot, size()));
+    }
+
+    void addOffsetField(int slot, int ref)
+    {
+        pushOffset(ref);
+        m_fields.push_back(std::make_pair(slot, size()));
+    }
+
+    int endTable()
+    {
+        push<qint32>(0);
+        const int table = size();
+
+        int slotCount = 0;
+        for (const std::pair<int, int> &field : m_fields)
+            slotCount = std::max(slotCount, field.first + 1);
+        std::vector<quint16> offsets(static_cast<size_t>(slotCount), 0);
+        for (const std::pair<int, int> &field : m_fields)
+            offsets[static_cast<size_t>(field.first)] = static_cast<quint16>(table - field.second);
+
+        // vtable: its size, the table's size, then one offset per slot
+        for (int i = slotCount - 1; i >= 0; --i)
+            push<quint16>(offsets[static_cast<size_t>(i)]);
+        push<quint16>(static_cast<quint16>(table - m_tableStart));
+        push<quint16>(static_cast<quint16>((slotCount + 2) * 2));
+
+        qToLittleEndian<qint32>(size() - table, &m_buffer[m_buffer.size() - static_cast<size_t>(table)]);
+        return table;
+    }
+
+    std::vector<uchar> finish(int root)
+    {
+        align(4, m_minAlign);
+        pushOffset(root);
+        return m_buffer;
+    }
+
+private:
+    void align(size_t bytes, size_t alignment)
+    {
+        m_minAlign = std::max(m_minAlign, alignment);
+        const size_t padding = (alignment - (m_buffer.size() + bytes) % alignment) % alignment;
+        m_buffer.insert(m_buffer.begin(), padding, 0);
+    }
+
+    std::vector<uchar> m_buffer;
+    std::vector<std::pair<int, int> > m_fields;      // slot, position
+    int m_tableStart = 0;
+    size_t m_minAlign = 1;
+};
+
+void appendInt64(std::vector<uchar> &out, qint64 value)
+{
+    uchar bytes[8];
+    qToLittleEndian<qint64>(value, bytes);
+    out.insert(out.end(), bytes, bytes + 8);
+}
+
+int width(ArrowWriter::Type type)
+{
+    switch (type) {
+    case ArrowWriter::Int8:     return 1;
+    case ArrowWriter::UInt32:   return 4;
+    case ArrowWriter::Float32:  return 4;
+    case ArrowWriter::Int64:    return 8;
+    case ArrowWriter::UInt64:   return 8;
+    }
+    return 8;
+}
+
+size_t padded(size_t size)
+{
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+int buildSchema(FlatBuilder &fb, const std::vector<const char *> &names, const std::vector<ArrowWriter::Type> &types)
+{
+    std::vector<int> fields;
+    for (size_t i = 0; i < names.size(); ++i) {
+        const ArrowWriter::Type type = types[i];
+        const bool isFloat = type == ArrowWriter::Float32;
+
+        fb.startTable();
+        if (isFloat) {
+            fb.addField<qint16>(0, PrecisionSingle);
+        } else {
+            fb.addField<qint32>(0, width(type) * 8);
+            fb.addField<quint8>(1, type == ArrowWriter::Int8 || type == ArrowWriter::Int64 ? 1 : 0);
+        }
+        const int typeTable = fb.endTable();
+
+        const int name = fb.createString(names[i]);
+        const int children = fb.createOffsetVector(std::vector<int>());
+
+        fb.startTable();
+        fb.addOffsetField(0, name);
+        fb.addOffsetField(3, typeTable);
+        fb.addOffsetField(5, children);
+        fb.addField<quint8>(2, isFloat ? TypeFloatingPoint : TypeInt);
+        fb.addField<quint8>(1, 0);
+        fields.push_back(fb.endTable());
+    }
+
+    const int fieldVector = fb.createOffsetVector(fields);
+    fb.startTable();
+    fb.addOffsetField(1, fieldVector);
+    fb.addField<qint16>(0, 0);      // little endian
+    return fb.endTable();
+}
+
+}
+
+ArrowWriter::ArrowWriter()
+{
+}
+
+ArrowWriter::~ArrowWriter()
+{
+    close();
+}
+
+int ArrowWriter::addColumn(const char *name, Type type)
+{
+    if (isOpen() || static_cast<int>(m_columns.size()) >= MaxColumns)
+        return -1;
+
+    Column column;
+    column.name = name;
+    column.type = type;
+    column.width = width(type);
+    m_columns.push_back(column);
+    return static_cast<int>(m_columns.size()) - 1;
+}
+
+void ArrowWriter::clearColumns()
+{
+    if (!isOpen())
+        m_columns.clear();
+}
+
+bool ArrowWriter::open(const QString &path, int batchRows, Mode mode)
+{
+    close();
+    if (m_columns.empty())
+        return false;
+
+    m_file = fopen(QFile::encodeName(path).constData(), "wb");
+    if (!m_file) {
+        LOG_WARNING("Can't open Arrow file %1", path);
+        return false;
+    }
+
+    m_path = path;
+    m_position = 0;
+    m_failed = false;
+    m_batchRows = qMax(1, batchRows);
+    m_ringSize = mode == Background ? RingBatches : 1;
+    m_rows = 0;
+    m_fillRow = 0;
+    m_full = false;
+    m_totalRows = 0;
+    m_droppedRows = 0;
+    m_batches.clear();
+    m_head.store(0);
+    m_tail.store(0);
+
+    // Column buffers are only allocated here, rows never allocate
+    for (Column &column : m_columns)
+        column.data.assign(static_cast<size_t>(m_ringSize) * static_cast<size_t>(m_batchRows * column.width), 0);
+
+    writeBytes(Magic, sizeof(Magic));
+    writeMessage(schemaMessage(), 0, nullptr);
+    if (m_failed) {
+        close();
+        return false;
+    }
+
+    if (mode == Background) {
+        m_running.store(true);
+        m_thread = std::thread(&ArrowWriter::run, this);
+    }
+
+    return true;
+}
+
+bool ArrowWriter::close()
+{
+    if (!m_file)
+        return false;
+
+    if (m_rows > 0)
+        publishBatch();
+
+    // The writer thread finishes the published batches before it stops
+    if (m_thread.joinable()) {
+        m_running.store(false);
+        m_thread.join();
+    }
+
+    // End of stream marker, then the footer indexing all batches
+    const quint32 eos[2] = { qToLittleEndian(Continuation), 0 };
+    writeBytes(eos, sizeof(eos));
+
+    const std::vector<uchar> meta = footer();
+    writeBytes(meta.data(), meta.size());
+    uchar length[4];
+    qToLittleEndian<qint32>(static_cast<qint32>(meta.size()), length);
+    writeBytes(length, sizeof(length));
+    writeBytes(Magic, 6);
+
+    const bool ok = !m_failed && fclose(m_file) == 0;
+    m_file = nullptr;
+    for (Column &column : m_columns)
+        std::vector<uchar>().swap(column.data);
+
+    if (m_droppedRows > 0)
+        LOG_WARNING("Dropped %1 rows of %2 while the writer was behind", m_droppedRows, m_path);
+    if (ok)
+        LOG_INFO("Wrote %1 rows in %2 batches to %3", m_totalRows, static_cast<int>(m_batches.size()), m_path);
+    else
+        LOG_WARNING("Writing Arrow file %1 failed", m_path);
+    return ok;
+}
+
+uchar *ArrowWriter::cell(Column &column)
+{
+    if (m_full)
+        return column.spare;
+
+    return column.data.data() + (m_fillRow + static_cast<size_t>(m_rows)) * static_cast<size_t>(column.width);
+}
+
+void ArrowWriter::setInt(int column, qint64 value)
+{
+    Column &c = m_columns[static_cast<size_t>(column)];
+    uchar *out = cell(c);
+
+    switch (c.type) {
+    case Int8:      *out = static_cast<uchar>(static_cast<qint8>(value)); break;
+    case UInt32:    qToLittleEndian<quint32>(static_cast<quint32>(value), out); break;
+    case Int64:     qToLittleEndian<qint64>(value, out); break;
+    case UInt64:    qToLittleEndian<quint64>(static_cast<quint64>(value), out); break;
+    case Float32:   setFloat(column, static_cast<float>(value)); break;
+    }
+}
+
+void ArrowWriter::setFloat(int column, float value)
+{
+    Column &c = m_columns[static_cast<size_t>(column)];
+    if (c.type != Float32) {
+        setInt(column, static_cast<qint64>(value));
+        return;
+    }
+
+    quint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    qToLittleEndian<quint32>(bits, cell(c));
+}
+
+void ArrowWriter::commitRow()
+{
+    if (!m_file)
+        return;
+
+    if (m_full) {
+        // The row went to the spare cells, see if the writer made room for the next one
+        m_droppedRows++;
+        m_full = m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_acquire)
+                >= static_cast<quint32>(m_ringSize);
+        return;
+    }
+
+    m_totalRows++;
+    if (++m_rows == m_batchRows)
+        publishBatch();
+}
+
+void ArrowWriter::publishBatch()
+{
+    const quint32 head = m_head.load(std::memory_order_relaxed);
+    const int slot = static_cast<int>(head % static_cast<quint32>(m_ringSize));
+    m_slotRows[slot] = m_rows;
+    m_rows = 0;
+
+    if (!m_thread.joinable()) {
+        writeBatch(slot, m_slotRows[slot]);
+        return;
+    }
+
+    m_head.store(head + 1, std::memory_order_release);
+    m_full = head + 1 - m_tail.load(std::memory_order_acquire) >= static_cast<quint32>(m_ringSize);
+    m_fillRow = static_cast<size_t>((head + 1) % static_cast<quint32>(m_ringSize)) * static_cast<size_t>(m_batchRows);
+}
+
+void ArrowWriter::run()
+{
+    for (;;) {
+        const quint32 tail = m_tail.load(std::memory_order_relaxed);
+        if (tail != m_head.load(std::memory_order_acquire)) {
+            const int slot = static_cast<int>(tail % static_cast<quint32>(m_ringSize));
+            writeBatch(slot, m_slotRows[slot]);
+            m_tail.store(tail + 1, std::memory_order_release);
+            continue;
+        }
+
+        if (!m_running.load())
+            return;
+        std::this_thread::sleep_for(IdleWait);
+    }
+}
+
+quint64 ArrowWriter::rows() const
+{
+    return m_totalRows;
+}
+
+quint64 ArrowWriter::droppedRows() const
+{
+    return m_droppedRows;
+}
+
+int ArrowWriter::batches() const
+{
+    return static_cast<int>(m_batches.size());
+}
+
+bool ArrowWriter::writeBatch(int slot, int rows)
+{
+    // Body: per column an empty validity buffer (no nulls) and the values, 8 byte aligned
+    std::vector<uchar> nodes;
+    std::vector<uchar> buffers;
+    qint64 bodyLength = 0;
+    for (const Column &column : m_columns) {
+        appendInt64(nodes, rows);
+        appendInt64(nodes, 0);
+
+        const size_t bytes = static_cast<size_t>(rows * column.width);
+        appendInt64(buffers, bodyLength);
+        appendInt64(buffers, 0);
+        appendInt64(buffers, bodyLength);
+        appendInt64(buffers, static_cast<qint64>(bytes));
+        bodyLength += static_cast<qint64>(padded(bytes));
+    }
+
+    FlatBuilder fb;
+    const int nodeVector = fb.createStructVector(nodes, static_cast<int>(m_columns.size()), 8);
+    const int bufferVector = fb.createStructVector(buffers, static_cast<int>(m_columns.size()) * 2, 8);
+    fb.startTable();
+    fb.addField<qint64>(0, rows);
+    fb.addOffsetField(1, nodeVector);
+    fb.addOffsetField(2, bufferVector);
+    const int batch = fb.endTable();
+
+    fb.startTable();
+    fb.addField<qint64>(3, bodyLength);
+    fb.addOffsetField(2, batch);
+    fb.addField<quint8>(1, HeaderRecordBatch);
+    fb.addField<qint16>(0, MetadataV5);
+    const std::vector<uchar> meta = fb.finish(fb.endTable());
+
+    Block block;
+    writeMessage(meta, bodyLength, &block);
+    for (const Column &column : m_columns) {
+        const size_t bytes = static_cast<size_t>(rows * column.width);
+        writeBytes(column.data.data() + static_cast<size_t>(slot) * static_cast<size_t>(m_batchRows * column.width), bytes);
+        pad(padded(bytes) - bytes);
+    }
+
+    m_batches.push_back(block);
+    return !m_failed;
+}
+
+bool ArrowWriter::writeMessage(const std::vector<uchar> &metadata, qint64 bodyLength, Block *block)
+{
+    // Continuation marker, metadata length, metadata padded so the body starts 8 byte aligned
+    const size_t length = padded(8 + metadata.size()) - 8;
+    if (block) {
+        block->offset = m_position;
+        block->metadataLength = static_cast<int>(8 + length);
+        block->bodyLength = bodyLength;
+    }
+
+    uchar prefix[8];
+    qToLittleEndian<quint32>(Continuation, prefix);
+    qToLittleEndian<qint32>(static_cast<qint32>(length), prefix + 4);
+    writeBytes(prefix, sizeof(prefix));
+    writeBytes(metadata.data(), metadata.size());
+    pad(length - metadata.size());
+    return !m_failed;
+}
+
+bool ArrowWriter::writeBytes(const void *data, size_t size)
+{
+    if (size > 0 && fwrite(data, size, 1, m_file) != 1)
+        m_failed = true;
+    m_position += static_cast<qint64>(size);
+    return !m_failed;
+}
+
+bool ArrowWriter::pad(size_t size)
+{
+    static const uchar zeros[8] = {};
+    return writeBytes(zeros, size);
+}
+
+std::vector<uchar> ArrowWriter::schemaMessage() const
+{
+    std::vector<const char *> names;
+    std::vector<Type> types;
+    for (const Column &column : m_columns) {
+        names.push_back(column.name);
+        types.push_back(column.type);
+    }
+
+    FlatBuilder fb;
+    const int schema = buildSchema(fb, names, types);
+    fb.startTable();
+    fb.addField<qint64>(3, 0);
+    fb.addOffsetField(2, schema);
+    fb.addField<quint8>(1, HeaderSchema);
+    fb.addField<qint16>(0, MetadataV5);
+    return fb.finish(fb.endTable());
+}
+
+std::vector<uchar> ArrowWriter::footer() const
+{
+    std::vector<const char *> names;
+    std::vector<Type> types;
+    for (const Column &column : m_columns) {
+        names.push_back(column.name);
+        types.push_back(column.type);
+    }
+
+    // Block: offset, metadata length, padding, body length
+    std::vector<uchar> blocks;
+    for (const Block &block : m_batches) {
+        appendInt64(blocks, block.offset);
+        uchar meta[8] = {};
+        qToLittleEndian<qint32>(block.metadataLength, meta);
+        blocks.insert(blocks.end(), meta, meta + 8);
+        appendInt64(blocks, block.bodyLength);
+    }
+
+    FlatBuilder fb;
+    const int schema = buildSchema(fb, names, types);
+    const int batches = fb.createStructVector(blocks, static_cast<int>(m_batches.size()), 8);
+    const int dictionaries = fb.createStructVector(std::vector<uchar>(), 0, 8);
+    fb.startTable();
+    fb.addOffsetField(1, schema);
+    fb.addOffsetField(2, dictionaries);
+    fb.addOffsetField(3, batches);
+    fb.addField<qint16>(0, MetadataV5);
+    return fb.finish(fb.endTable());
+}
@@ -0,0 +1,104 @@
+#ifndef ARROWWRITER_H
+#define ARROWWRITER_H
+
+#include <QtGlobal>
+#include <QString>
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Minimal Apache Arrow IPC file writer (Feather v2) for flat tables of
+// non-null primitive columns. Rows fill preallocated column buffers, every
+// batchRows rows one record batch is written out, so memory stays bounded.
+// pyarrow.ipc.open_file, pandas.read_feather and polars.read_ipc open the
+// result directly, memory mapped.
+// In Background mode full batches are handed to a writer thread through a
+// single producer / single consumer ring of batch buffers, rows then only
+// store values. Rows arriving while every buffer waits for the disk are
+// dropped and counted.
+class ArrowWriter
+{
+public:
+    enum Type { Int8, UInt32, Int64, UInt64, Float32 };
+    enum Mode {
+        Inline,         // batches are written by the thread committing the row
+        Background      // batches are written by a writer thread
+    };
+
+    static const int MaxColumns = 48;
+    static const int RingBatches = 3;      // buffers of a Background writer, one filling
+
+    ArrowWriter();
+    ~ArrowWriter();
+
+    // Schema, before open(). name must outlive the writer (string literal)
+    int addColumn(const char *name, Type type);
+    void clearColumns();
+
+    bool open(const QString &path, int batchRows = 16384, Mode mode = Inline);
+    bool isOpen() const { return m_file != nullptr; }
+    bool close();
+
+    // Set every column of the row, then commit it
+    void setInt(int column, qint64 value);
+    void setFloat(int column, float value);
+    void commitRow();
+
+    quint64 rows() const;
+    quint64 droppedRows() const;
+    int batches() const;            // after close() in Background mode
+
+private:
+    Q_DISABLE_COPY(ArrowWriter)
+
+    struct Column {
+        const char *name;
+        Type type;
+        int width;
+        std::vector<uchar> data;    // ring of batch buffers, batchRows values each
+        uchar spare[8];             // target of a row that is going to be dropped
+    };
+
+    struct Block {
+        qint64 offset;
+        int metadataLength;
+        qint64 bodyLength;
+    };
+
+    uchar *cell(Column &column);
+    void publishBatch();
+    void run();
+    bool writeBatch(int slot, int rows);
+    bool writeMessage(const std::vector<uchar> &metadata, qint64 bodyLength, Block *block);
+    bool writeBytes(const void *data, size_t size);
+    bool pad(size_t size);
+
+    std::vector<uchar> schemaMessage() const;
+    std::vector<uchar> footer() const;
+
+    FILE *m_file = nullptr;
+    QString m_path;
+    qint64 m_position = 0;
+    bool m_failed = false;
+
+    std::vector<Column> m_columns;
+    int m_batchRows = 0;
+    int m_ringSize = 1;
+    int m_rows = 0;                 // in the batch being filled
+    size_t m_fillRow = 0;           // first row of that batch's buffer
+    bool m_full = false;            // every buffer waits for the writer
+    quint64 m_totalRows = 0;
+    quint64 m_droppedRows = 0;
+    std::vector<Block> m_batches;   // written batches, writer side
+
+    // Batches published by the producer and written by the writer thread
+    int m_slotRows[RingBatches];
+    std::atomic<quint32> m_head{0};
+    std::atomic<quint32> m_tail{0};
+    std::atomic<bool> m_running{false};
+    std::thread m_thread;
+};
+
+#endif // ARROWWRITER_H
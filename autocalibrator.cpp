@@ -0,0 +1,105 @@
+#include "autocalibrator.h"
+
+AutoCalibrator::AutoCalibrator()
+{
+    reset();
+}
+
+void AutoCalibrator::setSettings(const Settings &settings)
+{
+    m_settings = settings;
+    m_settings.warmupSeconds = qMax(0.001f, m_settings.warmupSeconds);
+    m_settings.minSpan = qMax(0.001f, m_settings.minSpan);
+}
+
+void AutoCalibrator::reset()
+{
+    m_started = false;
+    m_seeded = false;
+    m_startUs = 0;
+
+    const CalibrationProfile defaults;
+    for (int ch = 0; ch < FingerFrame::MaxChannels; ++ch) {
+        m_low[ch] = defaults.minimum[ch];
+        m_high[ch] = defaults.maximum[ch];
+        m_maximum[ch] = defaults.maximum[ch];
+        m_rest[ch] = defaults.rest[ch];
+        m_last[ch] = defaults.rest[ch];
+    }
+}
+
+void AutoCalibrator::seed(const CalibrationProfile &profile)
+{
+    m_started = false;
+    m_seeded = true;
+
+    for (int ch = 0; ch < FingerFrame::MaxChannels; ++ch) {
+        m_low[ch] = profile.minimum[ch];
+        m_high[ch] = profile.maximum[ch];
+        m_maximum[ch] = m_low[ch] + qMax(m_high[ch] - m_low[ch], m_settings.minSpan);
+        m_rest[ch] = profile.rest[ch];
+        m_last[ch] = profile.rest[ch];
+    }
+}
+
+void AutoCalibrator::update(const FingerFrame &frame)
+{
+    // Synthesized samples carry no information about the wearer
+    if (frame.flags & (FingerFrame::Filled | FingerFrame::Duplicate))
+        return;
+
+    const int channels = qMin(frame.channelCount, static_cast<int>(FingerFrame::MaxChannels));
+
+    // Fresh start, the first sample is the whole range
+    if (!m_started) {
+        m_started = true;
+        m_startUs = frame.timestampUs;
+        for (int ch = 0; ch < channels; ++ch) {
+            m_last[ch] = frame.channels[ch];
+            if (m_seeded)
+                continue;
+            m_low[ch] = frame.channels[ch];
+            m_high[ch] = frame.channels[ch];
+            m_maximum[ch] = frame.channels[ch] + m_settings.minSpan;
+            m_rest[ch] = frame.channels[ch];
+        }
+        return;
+    }
+
+    // Step fades linearly from warmRate to rate over the warm-up
+    float rate = m_settings.rate;
+    if (!m_seeded) {
+        const float warm = 1.0f - (frame.timestampUs - m_startUs) * 1e-6f / m_settings.warmupSeconds;
+        if (warm > 0.0f)
+            rate += (m_settings.warmRate - m_settings.rate) * warm;
+    }
+
+    const float lowQ = m_settings.lowQuantile;
+    const float highQ = m_settings.highQuantile;
+    for (int ch = 0; ch < channels; ++ch) {
+        const float x = frame.channels[ch];
+        const float span = qMax(m_high[ch] - m_low[ch], m_settings.minSpan);
+        const float step = rate * span;
+
+        // Stochastic quantile estimates, each settles where the step up and down balance
+        m_low[ch] += x < m_low[ch] ? -step * (1.0f - lowQ) : step * lowQ;
+        m_high[ch] += x < m_high[ch] ? -step * (1.0f - highQ) : step * highQ;
+        m_maximum[ch] = m_low[ch] + qMax(m_high[ch] - m_low[ch], m_settings.minSpan);
+
+        // Rest is the zero of the flexion, a fist held still must not pull it up
+        if (qAbs(x - m_last[ch]) < m_settings.stillBand * span && x < m_low[ch] + 0.5f * span)
+            m_rest[ch] += m_settings.restRate * (x - m_rest[ch]);
+        m_last[ch] = x;
+    }
+}
+
+float AutoCalibrator::normalize(int channel, float raw) const
+{
+    // Same as CalibrationProfile::normalize with the learned values
+    const float zero = qBound(m_low[channel], m_rest[channel], m_maximum[channel]);
+    const float range = m_maximum[channel] - zero;
+    if (range <= 0.0f)
+        return 0.0f;
+
+    return qBound(0.0f, (raw - zero) / range, 1.0f);
+}
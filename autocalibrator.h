@@ -0,0 +1,60 @@
+#ifndef AUTOCALIBRATOR_H
+#define AUTOCALIBRATOR_H
+
+#include <QtGlobal>
+
+#include "fingerframe.h"
+#include "calibrationprofile.h"
+
+// Learns the range and rest pose of every channel while frames stream in.
+// Range ends are tracked as a low and a high quantile whose step shrinks from
+// a fast warm-up to a slow drift, so single spikes don't stretch the range and
+// a glove that is put on differently is followed. Rest is the average of the
+// frames a channel didn't move in. update() costs a few multiply-adds per
+// channel and never allocates, it runs on the notification path.
+class AutoCalibrator
+{
+public:
+    struct Settings {
+        float lowQuantile = 0.02f;
+        float highQuantile = 0.98f;
+        float warmRate = 0.05f;         // step per frame as fraction of the range, at the start of the warm-up
+        float rate = 0.001f;            // after the warm-up and for seeded ranges
+        float warmupSeconds = 5.0f;
+        float minSpan = 8.0f;           // raw units, range floor until the wearer moved
+        float stillBand = 0.01f;        // fraction of the range a resting channel moves between frames
+        float restRate = 0.02f;
+    };
+
+    AutoCalibrator();
+
+    void setSettings(const Settings &settings);
+
+    // Learns from scratch, starting with the next frame
+    void reset();
+    // Continues from saved ranges at the slow rate
+    void seed(const CalibrationProfile &profile);
+
+    void update(const FingerFrame &frame);
+
+    // Learned ranges, for CalibrationProfile / HandModel::setRanges
+    const float *minimum() const { return m_low; }
+    const float *maximum() const { return m_maximum; }
+    const float *rest() const { return m_rest; }
+    float normalize(int channel, float raw) const;
+
+private:
+    Settings m_settings;
+
+    bool m_started = false;
+    bool m_seeded = false;
+    qint64 m_startUs = 0;
+
+    float m_low[FingerFrame::MaxChannels];
+    float m_high[FingerFrame::MaxChannels];
+    float m_maximum[FingerFrame::MaxChannels];     // m_low plus the range, at least minSpan
+    float m_rest[FingerFrame::MaxChannels];
+    float m_last[FingerFrame::MaxChannels];
+};
+
+#endif // AUTOCALIBRATOR_H
@@ -0,0 +1,154 @@
+#include "benchmarks.h"
+#include "framesubscriber.h"
+#include "orientationfilter.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+// Frames offered between two event loop iterations of the producer
+const int FramesPerIteration = 16;
+
+// Gloves fused side by side and their IMU sample rate
+const int Gloves = 4;
+const int ImuRateHz = 1000;
+// Distinct synthetic samples cycled through, big enough to defeat branch prediction
+const int ImuVariants = 1024;
+
+struct DeliveryResult {
+    qint64 elapsedNs = 0;
+    quint64 deliveries = 0;
+};
+
+// Producer on this thread, receiver on a worker thread, timed until the last frame arrived
+DeliveryResult deliver(const PublishPolicy &policy, int frames)
+{
+    QThread worker;
+    worker.start();
+    QObject receiver;
+    receiver.moveToThread(&worker);
+
+    std::atomic<quint64> received(0);
+    std::atomic<quint64> deliveries(0);
+    FrameSubscriber subscriber(policy);
+    QObject::connect(&subscriber, &FrameSubscriber::frameReady, &receiver, [&](const FingerFrame &) {
+        received.fetch_add(1, std::memory_order_relaxed);
+        deliveries.fetch_add(1, std::memory_order_relaxed);
+    });
+    QObject::connect(&subscriber, &FrameSubscriber::framesReady, &receiver, [&](const FrameBatch &batch) {
+        received.fetch_add(static_cast<quint64>(batch.size()), std::memory_order_relaxed);
+        deliveries.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    FingerFrame frame;
+    frame.channelCount = 6;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < frames; ++i) {
+        frame.timestampUs = i * 1000;
+        frame.channels[i % 6] = static_cast<float>(i & 0xff);
+        subscriber.offer(frame);
+        if (i % FramesPerIteration == FramesPerIteration - 1)
+            QCoreApplication::processEvents();
+    }
+    while (received.load(std::memory_order_relaxed) < static_cast<quint64>(frames)) {
+        QCoreApplication::processEvents();
+        QThread::yieldCurrentThread();
+    }
+
+    DeliveryResult result;
+    result.elapsedNs = timer.nsecsElapsed();
+    result.deliveries = deliveries.load();
+
+    worker.quit();
+    worker.wait();
+    return result;
+}
+
+void report(const char *name, const DeliveryResult &result, int frames)
+{
+    fprintf(stderr, "%-10s %8d frames %8llu deliveries %10.1f ns/frame\n", name, frames,
+            static_cast<unsigned long long>(result.deliveries),
+            static_cast<double>(result.elapsedNs) / frames);
+}
+
+}
+
+int Benchmarks::delivery(int frames)
+{
+    qRegisterMetaType<FingerFrame>("FingerFrame");
+    qRegisterMetaType<FrameBatch>("FrameBatch");
+
+    PublishPolicy perSample;
+    perSample.delivery = PublishPolicy::PerSample;
+
+    PublishPolicy batched;
+    batched.delivery = PublishPolicy::Batched;
+    batched.batchIntervalMs = 0;
+
+    // First run warms up thread creation and the metatype system
+    deliver(perSample, qMin(frames, 1000));
+
+    report("perSample", deliver(perSample, frames), frames);
+    report("batched", deliver(batched, frames), frames);
+    return 0;
+}
+
+int Benchmarks::orientation(int samples)
+{
+    // Slow rotation about all axes with gravity and some sensor noise
+    QVector<ImuSample> imu(ImuVariants);
+    for (int i = 0; i < ImuVariants; ++i) {
+        const float t = static_cast<float>(i) / ImuVariants * 6.2831853f;
+        const float noise = static_cast<float>((i * 7919) % 101 - 50) * 1e-4f;
+        imu[i].accel[0] = 0.1f * std::sin(t) + noise;
+        imu[i].accel[1] = 0.1f * std::cos(t) - noise;
+        imu[i].accel[2] = 1.0f + noise;
+        imu[i].gyro[0] = 0.5f * std::cos(t);
+        imu[i].gyro[1] = 0.3f * std::sin(2.0f * t);
+        imu[i].gyro[2] = 0.2f + noise;
+    }
+
+    OrientationFilter filters[Gloves];
+    const qint64 stepUs = 1000000 / ImuRateHz;
+
+    // Samples of all gloves interleaved as they arrive on the Qt thread
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < samples; ++i) {
+        for (int g = 0; g < Gloves; ++g) {
+            ImuSample sample = imu.at((i + g * 97) % ImuVariants);
+            sample.timestampUs = (i + 1) * stepUs;
+            filters[g].update(sample);
+        }
+    }
+    const qint64 elapsedNs = timer.nsecsElapsed();
+
+    // Keeps the filter work observable to the optimizer
+    float sum = 0.0f;
+    for (int g = 0; g < Gloves; ++g)
+        sum += filters[g].quaternion()[0];
+
+    const double perSample = static_cast<double>(elapsedNs) / (static_cast<double>(samples) * Gloves);
+    fprintf(stderr, "orientation %d gloves x %d samples %8.1f ns/sample, %.3f%% of one core at %d Hz (w sum %.3f)\n",
+            Gloves, samples, perSample, perSample * Gloves * ImuRateHz / 1e7, ImuRateHz, sum);
+    return 0;
+}
+
+int Benchmarks::run(const QString &name, int samples)
+{
+    if (name == "delivery")
+        return delivery(samples > 0 ? samples : 200000);
+    if (name == "orientation")
+        return orientation(samples > 0 ? samples : 1000000);
+
+    fprintf(stderr, "Unknown benchmark %s, one of: delivery, orientation\n", qPrintable(name));
+    return 1;
+}
@@ -0,0 +1,19 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <QStringList>
+
+// Micro benchmarks of the stream pipeline, run with --bench <name> [samples].
+// Results go to stderr, the return value is the process exit code.
+namespace Benchmarks {
+
+// Cross-thread delivery of the same frames per sample and batched
+int delivery(int frames);
+// Madgwick update() cost per sample with several gloves interleaved
+int orientation(int samples);
+
+int run(const QString &name, int samples);
+
+}
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,102 @@
+#include "calibrationprofile.h"
+
+#include <QFile>
+#include <QSettings>
+#include <QStringList>
+
+namespace {
+
+QStringList toStringList(const float *values, int count)
+{
+    QStringList list;
+    for (int i = 0; i < count; ++i)
+        list << QString::number(values[i]);
+    return list;
+}
+
+void fromStringList(const QStringList &list, float *values, int count)
+{
+    for (int i = 0; i < count && i < list.size(); ++i)
+        values[i] = list.at(i).toFloat();
+}
+
+}
+
+CalibrationProfile::CalibrationProfile()
+{
+    for (int ch = 0; ch < FingerFrame::MaxChannels; ++ch) {
+        minimum[ch] = 0.0f;
+        maximum[ch] = 255.0f;
+        rest[ch] = 0.0f;
+        for (int p = 0; p < CurvePoints; ++p)
+            curve[ch][p] = static_cast<float>(p) / (CurvePoints - 1);
+    }
+}
+
+float CalibrationProfile::normalize(int channel, float raw) const
+{
+    // Flexion counts from the rest pose, readings between minimum and rest are the open hand
+    const float zero = qBound(minimum[channel], rest[channel], maximum[channel]);
+    const float range = maximum[channel] - zero;
+    if (range <= 0.0f)
+        return 0.0f;
+
+    return qBound(0.0f, (raw - zero) / range, 1.0f);
+}
+
+float CalibrationProfile::response(int channel, float normalized) const
+{
+    const float x = qBound(0.0f, normalized, 1.0f) * (CurvePoints - 1);
+    const int i = qMin(static_cast<int>(x), CurvePoints - 2);
+    const float w = x - i;
+
+    return curve[channel][i] + (curve[channel][i + 1] - curve[channel][i]) * w;
+}
+
+bool CalibrationProfile::load(const QString &path)
+{
+    if (path.isEmpty() || !QFile::exists(path))
+        return false;
+
+    QSettings Setting(path, QSettings::IniFormat);
+
+    Setting.beginGroup("Profile");
+    user = Setting.value("user").toString();
+    glove = Setting.value("glove").toString();
+    Setting.endGroup();
+
+    Setting.beginGroup("Channels");
+    fromStringList(Setting.value("minimum").toStringList(), minimum, FingerFrame::MaxChannels);
+    fromStringList(Setting.value("maximum").toStringList(), maximum, FingerFrame::MaxChannels);
+    fromStringList(Setting.value("rest").toStringList(), rest, FingerFrame::MaxChannels);
+    for (int ch = 0; ch < FingerFrame::MaxChannels; ++ch)
+        fromStringList(Setting.value(QString("curve%1").arg(ch)).toStringList(), curve[ch], CurvePoints);
+    Setting.endGroup();
+
+    return true;
+}
+
+bool CalibrationProfile::save(const QString &path) const
+{
+    if (path.isEmpty())
+        return false;
+
+    QSettings Setting(path, QSettings::IniFormat);
+
+    Setting.beginGroup("Profile");
+    Setting.setValue("user", user);
+    Setting.setValue("glove", glove);
+    Setting.endGroup();
+
+    Setting.beginGroup("Channels");
+    Setting.setValue("minimum", toStringList(minimum, FingerFrame::MaxChannels));
+    Setting.setValue("maximum", toStringList(maximum, FingerFrame::MaxChannels));
+    Setting.setValue("rest", toStringList(rest, FingerFrame::MaxChannels));
+    for (int ch = 0; ch < FingerFrame::MaxChannels; ++ch)
+        Setting.setValue(QString("curve%1").arg(ch), toStringList(curve[ch], CurvePoints));
+    Setting.endGroup();
+
+    // Unwritable files only show up in the status after the sync
+    Setting.sync();
+    return Setting.status() == QSettings::NoError;
+}
@@ -0,0 +1,34 @@
+#ifndef CALIBRATIONPROFILE_H
+#define CALIBRATIONPROFILE_H
+
+#include <QString>
+
+#include "fingerframe.h"
+
+// Per user and glove sensor calibration, stored as ini file
+struct CalibrationProfile
+{
+    static const int CurvePoints = 5;
+
+    CalibrationProfile();
+
+    QString user;
+    QString glove;
+
+    // Raw sensor values of the open and the fully bent hand and the rest pose
+    float minimum[FingerFrame::MaxChannels];
+    float maximum[FingerFrame::MaxChannels];
+    float rest[FingerFrame::MaxChannels];
+
+    // Sensor response, normalized flex -> normalized flexion at evenly spaced points
+    float curve[FingerFrame::MaxChannels][CurvePoints];
+
+    // 0 at the rest pose (or minimum, if rest is below it) to 1 at maximum
+    float normalize(int channel, float raw) const;
+    float response(int channel, float normalized) const;
+
+    bool load(const QString &path);
+    bool save(const QString &path) const;
+};
+
+#endif // CALIBRATIONPROFILE_H
@@ -0,0 +1,225 @@
+#include "captoglove_c.h"
+
+#include "captogloveapi.h"
+#include "framering.h"
+#include "wakeupfd.h"
+
+#include <QCoreApplication>
+#include <QSemaphore>
+#include <QThread>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+struct captoglove_session
+{
+    CaptoGloveAPI *api = nullptr;           // lives on the Qt thread
+    FrameRing frames;
+    WakeupFd wakeup;
+    std::atomic<int> state{CAPTOGLOVE_IDLE};
+};
+
+namespace {
+
+// Hidden Qt thread every session lives on. A host that already runs a
+// QCoreApplication gets a worker QThread instead of a second application.
+class QtRuntime
+{
+public:
+    static QtRuntime *instance()
+    {
+        static QtRuntime runtime;
+        return &runtime;
+    }
+
+    // Runs fn on the Qt thread and waits for it
+    template <typename Fn>
+    void run(Fn fn)
+    {
+        if (QThread::currentThread() == m_context->thread())
+            fn();
+        else
+            QMetaObject::invokeMethod(m_context, fn, Qt::BlockingQueuedConnection);
+    }
+
+    template <typename Fn>
+    void post(Fn fn)
+    {
+        QMetaObject::invokeMethod(m_context, fn, Qt::QueuedConnection);
+    }
+
+private:
+    QtRuntime()
+    {
+        if (QCoreApplication::instance()) {
+            m_thread = new QThread;
+            m_thread->start();
+            m_context = new QObject;
+            m_context->moveToThread(m_thread);
+            return;
+        }
+
+        QSemaphore ready;
+        m_appThread = std::thread([this, &ready]() {
+            static int argc = 1;
+            static char name[] = "captoglove";
+            static char *argv[] = { name, nullptr };
+
+            QCoreApplication app(argc, argv);
+            m_context = new QObject;
+            ready.release();
+            app.exec();
+            delete m_context;
+        });
+        ready.acquire();
+    }
+
+    ~QtRuntime()
+    {
+        if (m_appThread.joinable()) {
+            QMetaObject::invokeMethod(QCoreApplication::instance(), "quit", Qt::QueuedConnection);
+            m_appThread.join();
+        } else if (m_thread) {
+            m_context->deleteLater();
+            m_thread->quit();
+            m_thread->wait();
+            delete m_thread;
+        }
+    }
+
+    QObject *m_context = nullptr;
+    QThread *m_thread = nullptr;
+    std::thread m_appThread;
+};
+
+static_assert(HandPose::FingerCount == CAPTOGLOVE_FINGERS, "captoglove_latest.flexion follows HandPose");
+
+void toCFrame(captoglove_frame &to, const FingerFrame &from)
+{
+    to.sequence = from.sequence;
+    to.timestamp_us = from.timestampUs;
+    to.flags = from.flags;
+    to.channel_count = from.channelCount;
+    memcpy(to.channels, from.channels, sizeof(to.channels));
+    memcpy(to.orientation, from.orientation, sizeof(to.orientation));
+}
+
+}
+
+int captoglove_abi_version(void)
+{
+    return CAPTOGLOVE_ABI_VERSION;
+}
+
+captoglove_session *captoglove_open(const char *config_path)
+{
+    const QString configPath = config_path ? QString::fromUtf8(config_path) : QString();
+
+    captoglove_session *session = new captoglove_session;
+    QtRuntime::instance()->run([session, configPath]() {
+        session->api = new CaptoGloveAPI(nullptr, configPath);
+
+        // Direct connections, everything below runs on the Qt thread
+        QObject::connect(session->api, &CaptoGloveAPI::frameReceived, session->api, [session](const FingerFrame &frame) {
+            if (session->frames.push(frame))
+                session->wakeup.notify();
+        });
+        QObject::connect(session->api, &CaptoGloveAPI::initialized, session->api, [session]() {
+            session->state.store(CAPTOGLOVE_STREAMING);
+        });
+        QObject::connect(session->api, &CaptoGloveAPI::disconnected, session->api, [session]() {
+            session->state.store(CAPTOGLOVE_DISCONNECTED);
+        });
+    });
+
+    if (!session->api) {
+        delete session;
+        return nullptr;
+    }
+
+    return session;
+}
+
+int captoglove_connect(captoglove_session *session, const char *device_name)
+{
+    if (!session)
+        return -1;
+
+    const QString name = device_name ? QString::fromUtf8(device_name) : QString();
+    session->state.store(CAPTOGLOVE_CONNECTING);
+    QtRuntime::instance()->post([session, name]() {
+        if (!name.isEmpty())
+            session->api->setWantedDevice(name);
+        session->api->run();
+    });
+
+    return 0;
+}
+
+int captoglove_poll(captoglove_session *session, captoglove_frame *frames, int max_frames)
+{
+    if (!session || !frames || max_frames <= 0)
+        return 0;
+
+    const int count = session->frames.pop(frames, max_frames, toCFrame);
+    if (count < max_frames)
+        session->wakeup.drained([session]() { return session->frames.size() > 0; });
+
+    return count;
+}
+
+int captoglove_get_fd(const captoglove_session *session)
+{
+    return session ? session->wakeup.fd() : -1;
+}
+
+captoglove_state captoglove_get_state(const captoglove_session *session)
+{
+    return session ? static_cast<captoglove_state>(session->state.load()) : CAPTOGLOVE_IDLE;
+}
+
+int captoglove_get_latest(const captoglove_session *session, captoglove_latest *latest)
+{
+    if (!session || !session->api || !latest)
+        return -1;
+
+    // Reads the seqlock of the API directly, nothing runs on the Qt thread
+    const GloveState state = session->api->getLatestState();
+    toCFrame(latest->frame, state.frame);
+    memcpy(latest->flexion, state.pose.flexion, sizeof(latest->flexion));
+    latest->battery = state.battery;
+    latest->rssi = state.rssi;
+    latest->battery_us = state.batteryUs;
+    latest->state_us = state.connectionUs;
+    latest->updates = state.updates;
+
+    switch (state.connection) {
+    case GloveState::Connecting:    latest->state = CAPTOGLOVE_CONNECTING; break;
+    case GloveState::Streaming:     latest->state = CAPTOGLOVE_STREAMING; break;
+    case GloveState::Stalled:       latest->state = CAPTOGLOVE_STALLED; break;
+    case GloveState::Disconnected:  latest->state = CAPTOGLOVE_DISCONNECTED; break;
+    default:                        latest->state = CAPTOGLOVE_IDLE; break;
+    }
+
+    return 0;
+}
+
+uint64_t captoglove_dropped(const captoglove_session *session)
+{
+    return session ? session->frames.dropped() : 0;
+}
+
+void captoglove_close(captoglove_session *session)
+{
+    if (!session)
+        return;
+
+    // Once this returns no more frames are pushed into the session
+    QtRuntime::instance()->run([session]() {
+        delete session->api;
+        session->api = nullptr;
+    });
+
+    delete session;
+}
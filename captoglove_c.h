@@ -0,0 +1,98 @@
+#ifndef CAPTOGLOVE_C_H
+#define CAPTOGLOVE_C_H
+
+/*
+ * Plain C interface of the shared library build (CONFIG += CAPTOGLOVEAPI_LIBRARY).
+ * Qt runs on a hidden thread inside the library, the host needs no event loop.
+ * captoglove_poll and captoglove_get_latest neither allocate nor lock and may be called from a real-time loop.
+ */
+
+#include <stdint.h>
+
+#if defined(CAPTOGLOVEAPI_LIBRARY)
+#  define CAPTOGLOVE_EXPORT __attribute__((visibility("default")))
+#else
+#  define CAPTOGLOVE_EXPORT
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CAPTOGLOVE_ABI_VERSION      1
+#define CAPTOGLOVE_MAX_CHANNELS     10
+
+/* captoglove_frame.flags */
+#define CAPTOGLOVE_FRAME_GAP_BEFORE         0x01
+#define CAPTOGLOVE_FRAME_FILLED             0x02
+#define CAPTOGLOVE_FRAME_HAS_ORIENTATION    0x08
+
+typedef struct captoglove_frame {
+    uint64_t sequence;
+    int64_t timestamp_us;
+    uint32_t flags;
+    int32_t channel_count;
+    float channels[CAPTOGLOVE_MAX_CHANNELS];
+    float orientation[4];                   /* w, x, y, z */
+} captoglove_frame;
+
+typedef enum captoglove_state {
+    CAPTOGLOVE_IDLE = 0,
+    CAPTOGLOVE_CONNECTING = 1,
+    CAPTOGLOVE_STREAMING = 2,
+    CAPTOGLOVE_DISCONNECTED = 3,
+    CAPTOGLOVE_STALLED = 4                  /* only reported by captoglove_get_latest */
+} captoglove_state;
+
+#define CAPTOGLOVE_FINGERS          5
+
+typedef struct captoglove_latest {
+    captoglove_frame frame;
+    float flexion[CAPTOGLOVE_FINGERS];      /* thumb to little, 0 open - 1 fully bent */
+    int32_t battery;                        /* percent, -1 unknown */
+    int32_t rssi;                           /* dBm at discovery, 0 unknown */
+    int32_t state;                          /* captoglove_state */
+    int64_t battery_us;                     /* timestamps on the clock of frame.timestamp_us */
+    int64_t state_us;
+    uint64_t updates;                       /* grows with every change */
+} captoglove_latest;
+
+typedef struct captoglove_session captoglove_session;
+
+CAPTOGLOVE_EXPORT int captoglove_abi_version(void);
+
+/* config_path may be NULL for the default config.ini. Returns NULL on failure. */
+CAPTOGLOVE_EXPORT captoglove_session *captoglove_open(const char *config_path);
+
+/* Scans for and connects to the named glove, NULL uses deviceName from the config. Returns 0 on success. */
+CAPTOGLOVE_EXPORT int captoglove_connect(captoglove_session *session, const char *device_name);
+
+/* Copies up to max_frames queued frames, oldest first. Returns the number copied. */
+CAPTOGLOVE_EXPORT int captoglove_poll(captoglove_session *session, captoglove_frame *frames, int max_frames);
+
+/*
+ * eventfd that becomes readable when frames are queued, for epoll/libuv/asio
+ * reactors. It is edge coalesced: after a wakeup call captoglove_poll until it
+ * returns fewer frames than asked for, that re-arms the descriptor. Reading
+ * the descriptor is not required. Returns -1 where eventfd is not available.
+ */
+CAPTOGLOVE_EXPORT int captoglove_get_fd(const captoglove_session *session);
+
+CAPTOGLOVE_EXPORT captoglove_state captoglove_get_state(const captoglove_session *session);
+
+/*
+ * Newest frame, pose, battery, RSSI and link state as one consistent snapshot,
+ * without dequeuing anything. Sample it at any rate. Returns 0 on success.
+ */
+CAPTOGLOVE_EXPORT int captoglove_get_latest(const captoglove_session *session, captoglove_latest *latest);
+
+/* Frames dropped because the caller didn't poll fast enough */
+CAPTOGLOVE_EXPORT uint64_t captoglove_dropped(const captoglove_session *session);
+
+CAPTOGLOVE_EXPORT void captoglove_close(captoglove_session *session);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAPTOGLOVE_C_H */
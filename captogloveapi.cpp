@@ -12,6 +12,8 @@ CaptoGloveAPI::CaptoGloveAPI(QObject *parent,  QString configPath) : QObject(par
     m_foundScanParametersService = false;
     m_foundHIDService = false;
     m_foundHIDControlPointService = false;
+    m_foundDeviceInfoService = false;
+    m_foundFingerPositionService = false;
 
     m_connected = false;
 
@@ -19,9 +21,25 @@ CaptoGloveAPI::CaptoGloveAPI(QObject *parent,  QString configPath) : QObject(par
     m_reconnect = true;
     m_scanTimeout = 5000;
 
+    setupMetrics();
+
+    m_traceTrack = ConnectionTrace::instance()->addTrack("CaptoGlove");
+    m_subscriptions.setTraceTrack(m_traceTrack);
+
     // Load or create default config file
     QFile configFile(m_configPath);
     if (m_configPath == "") m_configPath = tr("%1/%2").arg(PROJECT_PATH).arg("config.ini");
+    loadSettings(m_configPath);
+    setupSubscriptions();
+    setupDeviceInformation();
+    setupWatchdog();
+    setupFailover();
+
+    qRegisterMetaType<FingerFrame>("FingerFrame");
+    qRegisterMetaType<FrameBatch>("FrameBatch");
+    qRegisterMetaType<HandPose>("HandPose");
+    qRegisterMetaType<ListingSnapshotPtr>("ListingSnapshotPtr");
+    m_streamClock.start();
 
     // initialize Bluetooth Discovery agent
     m_discoveryAgent = new QBluetoothDeviceDiscoveryAgent();
@@ -42,12 +60,59 @@ CaptoGloveAPI::CaptoGloveAPI(QObject *parent,  QString configPath) : QObject(par
 
     connect(this, SIGNAL(initialized()), this, SLOT(processLoop()));
 
+    // Connect time of the configured service profile, once per connection
+    connect(&m_subscriptions, &SubscriptionManager::allSubscribed, this, [this]() {
+        if (!m_connectTimer.isValid())
+            return;
+        const qint64 elapsedMs = m_connectTimer.elapsed();
+        m_connectTimer.invalidate();
+        m_connectTimeGauge->set(elapsedMs);
+        connectTimeHistogram()->observe(elapsedMs);
+
+        int opened = 0;
+        for (const ServiceInfo *service : qAsConst(m_services))
+            opened += service->service() ? 1 : 0;
+        LOG_INFO("Streaming %1 ms after connecting with the %2 profile, %3 of %4 services opened",
+                 elapsedMs, m_profile.name, opened, m_services.size());
+    });
+
+    // One recording per connection, started once the finger stream is subscribed
+    connect(&m_subscriptions, &SubscriptionManager::subscribed, this, [this](const QBluetoothUuid &characteristic) {
+        if (characteristic == CaptoGloveUuids::fingerPositions())
+            startRecording();
+    });
+
+    // Calibration follows the glove that delivers, and is saved now and then while learning
+    connect(this, &CaptoGloveAPI::failedOver, this, [this](const QString &, const QString &to, const QString &) {
+        startCalibration(to);
+    });
+    connect(&m_calibrationSaveTimer, &QTimer::timeout, this, &CaptoGloveAPI::saveCalibration);
+
+    // Only frames passing the publish policy update the finger state
+    connect(this, &CaptoGloveAPI::frameReceived, &m_fingerStatePublisher, &FrameSubscriber::offer);
+    connect(&m_fingerStatePublisher, &FrameSubscriber::frameReady, this, &CaptoGloveAPI::updateFingerState);
+
     // Update corresponding protobuffer msgs
     connect(this, SIGNAL(updateFingerState()), this, SLOT(setFingerMsg()));
     connect(this, SIGNAL(updateBatteryState()), this, SLOT(setBatteryMsg()));
 }
 
 CaptoGloveAPI::~CaptoGloveAPI() {
+
+    // Embedders create and drop instances at runtime, don't leave the link up
+    m_reconnect = false;
+    saveCalibration();
+    if (!m_traceFile.isEmpty())
+        saveTrace(m_traceFile);
+    // Service objects go before the controller that created them
+    releaseServices();
+    if (m_controller) {
+        m_controller->disconnectFromDevice();
+        delete m_controller;
+    }
+    delete m_discoveryAgent;
+    delete localDevice;
+    qDeleteAll(m_devices);
 }
 
 
@@ -56,16 +121,18 @@ void CaptoGloveAPI::startDeviceDiscovery()
 {
     qDeleteAll(m_devices);
     m_devices.clear();
-    emit devicesUpdated();
+    publishDevices();
 
 
+    ConnectionTrace::instance()->end(m_traceDiscovery);
+    m_traceDiscovery = ConnectionTrace::instance()->begin(m_traceTrack, "deviceDiscovery");
     m_discoveryAgent->start(QBluetoothDeviceDiscoveryAgent::LowEnergyMethod);
 
     if (m_discoveryAgent->isActive()) {
         m_deviceScanState = true;
         Q_EMIT stateChanged();
     }else{
-        qDebug() << "Discovery agent failed to start!";
+        LOG_WARNING("Discovery agent failed to start!");
     }
 }
 
@@ -83,7 +150,9 @@ void CaptoGloveAPI::deviceScanError(QBluetoothDeviceDiscoveryAgent::Error error)
     }
 
     m_deviceScanState = false;
-    emit devicesUpdated();
+    ConnectionTrace::instance()->end(m_traceDiscovery);
+    m_traceDiscovery = -1;
+    publishDevices();
     emit stateChanged();
 }
 
@@ -94,14 +163,18 @@ void CaptoGloveAPI::addDevice(const QBluetoothDeviceInfo &device){
     // DeviceInfo foundDevice;
     if (device.coreConfigurations() & QBluetoothDeviceInfo::LowEnergyCoreConfiguration){
         m_devices.append(new DeviceInfo(device));
-        qDebug() << "Device name:" << device.name();
-        qDebug() << "Device address:" << device.address();
+        LOG_DEBUG("Device name: %1", device.name());
+        LOG_DEBUG("Device address: %1", device.address().toString());
+        publishDevices();
     }
 
 }
 
 void CaptoGloveAPI::disconnectFromDevice(){
 
+    if (!m_controller)
+        return;
+
     if (m_controller->state() != QLowEnergyController::UnconnectedState)
         m_controller->disconnectFromDevice();
     else
@@ -132,6 +205,8 @@ void CaptoGloveAPI::initializeController(const QBluetoothDeviceInfo &info)
             this, &CaptoGloveAPI::addLowEnergyService);
     connect(m_controller, &QLowEnergyController::discoveryFinished,
             this, &CaptoGloveAPI::discoverServices);
+    connect(m_controller, &QLowEnergyController::connectionUpdated,
+            this, &CaptoGloveAPI::connectionUpdated);
     }
 
     // Set remote address to random
@@ -140,7 +215,7 @@ void CaptoGloveAPI::initializeController(const QBluetoothDeviceInfo &info)
     else
         m_controller->setRemoteAddressType(QLowEnergyController::PublicAddress);
 
-    qDebug() << tr("Connecting to device: %1").arg(info.name());
+    LOG_INFO("Connecting to device: %1", info.name());
 
 
 }
@@ -149,112 +224,417 @@ void CaptoGloveAPI::initializeController(const QBluetoothDeviceInfo &info)
 // ############## LOW ENERGY CONTROLLER SLOTS ##############
 void CaptoGloveAPI::deviceConnected()
 {
-    qDebug() << "Device connected. Scanning services.";
+    LOG_INFO("Device connected. Scanning services.");
+    ConnectionTrace::instance()->end(m_traceConnect);
+    m_traceConnect = -1;
+    m_traceServices = ConnectionTrace::instance()->begin(m_traceTrack, "discoverServices");
     setUpdate("Back\n(Discovering services...)");
     m_connected = true;
+
+    // Objects of the previous connection are stale, the scan below creates them again
+    releaseServices();
+
+    // While the spare delivers, the stream state is its own
+    if (!m_onStandby) {
+        m_sequenceTracker.reset();
+        m_orientationFilter.reset();
+        m_lastImuUs = 0;
+        m_hasOrientation = false;
+    }
     m_controller->discoverServices();
 }
 
 void CaptoGloveAPI::deviceDisconnected()
 {
-    qWarning() << "Disconnected from the device!";
-    emit disconnected();
+    LOG_WARNING("Disconnected from the device!");
+
+    const SequenceTracker::Stats stats = m_sequenceTracker.stats();
+    LOG_INFO("Stream stats: received %1 lost %2 loss rate %3 connection interval %4 ms",
+             stats.received, stats.lost, stats.lossRate(), m_connectionIntervalMs);
+
+    m_subscriptions.reset();
+    m_deviceInfoReader.reset();
+    m_primaryLastUs = 0;
+    ConnectionTrace::instance()->instant(m_traceTrack, "disconnected");
+
+    // A streaming spare keeps the output going, this glove reconnects as its standby
+    if (!m_onStandby && !failover(QStringLiteral("disconnect"))) {
+        m_watchdog.suspend();
+        m_recorder.close();
+        m_arrowExport.close();
+        saveCalibration();
+        publishConnection(GloveState::Disconnected);
+        emit disconnected();
+    }
     // TODO: Add  reconnection logic
 
-    if (m_reconnect && m_controller)
+    if (m_reconnect && m_controller) {
+        m_reconnects->increment();
+        m_connectTimer.start();
+        ConnectionTrace::instance()->end(m_traceConnect);
+        ConnectionTrace::instance()->end(m_traceFirstSample);
+        m_traceConnect = ConnectionTrace::instance()->begin(m_traceTrack, "connect", "reconnect");
+        m_traceFirstSample = ConnectionTrace::instance()->begin(m_traceTrack, "timeToFirstSample", "reconnect");
+        if (!m_onStandby)
+            publishConnection(GloveState::Connecting);
         m_controller->connectToDevice();
+    }
 }
 
 void CaptoGloveAPI::errorReceived()
 {
-    qWarning() << "Error: " << m_controller->errorString();
+    LOG_ERROR("Error: %1", m_controller->errorString());
     setUpdate(QString("Back\n(%1)").arg(m_controller->errorString()));
 }
 
+void CaptoGloveAPI::connectionUpdated(const QLowEnergyConnectionParameters &params)
+{
+    m_connectionIntervalMs = params.minimumInterval();
+    m_connectionIntervalGauge->set(m_connectionIntervalMs);
+    m_fingerCommands.setConnectionInterval(m_connectionIntervalMs);
+    LOG_INFO("Connection interval is %1 ms", m_connectionIntervalMs);
+}
+
 void CaptoGloveAPI::serviceScanDone(){
 
-    qDebug() << "Service scan done!!!!!";
-    if (m_services.isEmpty())
-        emit servicesUpdated();
+    LOG_DEBUG("Service scan done!");
+
+    // Device information and generic access are only used by the info reader, which is
+    // also the first use of the lazy ones. Read in one batch, or taken from the cache
+    const QBluetoothUuid gaUuid(QBluetoothUuid::GenericAccess);
+    const QBluetoothUuid deviceInfoUuid(QBluetoothUuid::DeviceInformation);
+    const bool wantsGA = m_foundGAService && m_profile.mode(gaUuid) != ServiceProfile::Skip;
+    const bool wantsDeviceInfo = m_foundDeviceInfoService && m_profile.mode(deviceInfoUuid) != ServiceProfile::Skip;
+
+    for (const QBluetoothUuid &uuid : qAsConst(m_advertisedServices)) {
+        if (m_profile.mode(uuid) != ServiceProfile::Eager && !(uuid == gaUuid && wantsGA) && !(uuid == deviceInfoUuid && wantsDeviceInfo))
+            LOG_DEBUG("Not discovering details of %1 (%2 profile)", uuid.toString(), m_profile.name);
+    }
 
     // Battery service
-    if (m_foundBatteryLevelService){
-        qDebug() << "Battery Level service found!";
-        m_batteryLevelService = m_controller->createServiceObject(QBluetoothUuid::BatteryService);
-        connect(m_batteryLevelService, &QLowEnergyService::stateChanged, this, &CaptoGloveAPI::batteryServiceStateChanged);
-        connect(m_batteryLevelService, &QLowEnergyService::characteristicChanged, this, &CaptoGloveAPI::updateBatteryLevelValue);
-        connect(m_batteryLevelService, &QLowEnergyService::descriptorWritten, this, &CaptoGloveAPI::confirmedBatteryDescWrite);
+    if (!m_batteryLevelService && m_foundBatteryLevelService && m_profile.wants(QBluetoothUuid(QBluetoothUuid::BatteryService))){
+        LOG_DEBUG("Battery Level service found!");
+        m_batteryLevelService = openService(QBluetoothUuid::BatteryService);
+        if (m_batteryLevelService) {
+            connect(m_batteryLevelService, &QLowEnergyService::stateChanged, this, &CaptoGloveAPI::batteryServiceStateChanged);
+            connect(m_batteryLevelService, &QLowEnergyService::characteristicChanged, this, &CaptoGloveAPI::updateBatteryLevelValue);
+            connect(m_batteryLevelService, &QLowEnergyService::characteristicRead, this, &CaptoGloveAPI::updateBatteryLevelValue);
+            connect(m_batteryLevelService, &QLowEnergyService::descriptorWritten, this, &CaptoGloveAPI::confirmedBatteryDescWrite);
+            m_subscriptions.attach(m_batteryLevelService);
+        }
     }
     if (m_batteryLevelService){
+        traceDetails(m_batteryLevelService);
         m_batteryLevelService->discoverDetails();
     }
 
+    QList<QBluetoothUuid> infoServices;
+    if (wantsDeviceInfo)
+        infoServices << deviceInfoUuid;
+    if (wantsGA)
+        infoServices << gaUuid;
+    m_deviceInfoReader.start(m_peripheralDevice.getAddress(), infoServices);
+
     // Generic access service
-    if (m_foundGAService){
-        m_GAService = m_controller->createServiceObject(QBluetoothUuid::GenericAccess);
-        connect(m_GAService, &QLowEnergyService::stateChanged, this, &CaptoGloveAPI::genericAccessServiceStateChanged);
+    if (!m_GAService && wantsGA){
+        m_GAService = openService(QBluetoothUuid::GenericAccess);
+        if (m_GAService)
+            connect(m_GAService, &QLowEnergyService::stateChanged, this, &CaptoGloveAPI::genericAccessServiceStateChanged);
     }
     if (m_GAService){
-        qDebug() << "Discovering GA details";
-        m_GAService->discoverDetails();
+        m_deviceInfoReader.attach(m_GAService);
+        if (m_deviceInfoReader.needs(QBluetoothUuid(QBluetoothUuid::GenericAccess))) {
+            LOG_DEBUG("Discovering GA details");
+            traceDetails(m_GAService);
+            m_GAService->discoverDetails();
+        } else {
+            LOG_DEBUG("Not discovering GA details, cached");
+        }
     }
 
     // Scan parameters service
-    if (m_foundScanParametersService){
-        m_ScanParametersService = m_controller->createServiceObject(QBluetoothUuid::ScanParameters);
-        connect(m_ScanParametersService, &QLowEnergyService::stateChanged, this, &CaptoGloveAPI::scanParamsServiceStateChanged);
+    if (!m_ScanParametersService && m_foundScanParametersService && m_profile.wants(QBluetoothUuid(QBluetoothUuid::ScanParameters))){
+        m_ScanParametersService = openService(QBluetoothUuid::ScanParameters);
+        if (m_ScanParametersService)
+            connect(m_ScanParametersService, &QLowEnergyService::stateChanged, this, &CaptoGloveAPI::scanParamsServiceStateChanged);
     }
     if (m_ScanParametersService){
-        qDebug() << "Discovering Scan Parameters details";
+        LOG_DEBUG("Discovering Scan Parameters details");
+        traceDetails(m_ScanParametersService);
         m_ScanParametersService->discoverDetails();
     }
 
     // Human interface device service
-    if (m_foundHIDService){
-        m_HIDService = m_controller->createServiceObject(QBluetoothUuid::HumanInterfaceDevice);
-        connect(m_HIDService, &QLowEnergyService::stateChanged, this, &CaptoGloveAPI::HIDserviceStateChanged);
+    if (!m_HIDService && m_foundHIDService && m_profile.wants(QBluetoothUuid(QBluetoothUuid::HumanInterfaceDevice))){
+        m_HIDService = openService(QBluetoothUuid::HumanInterfaceDevice);
+        if (m_HIDService)
+            connect(m_HIDService, &QLowEnergyService::stateChanged, this, &CaptoGloveAPI::HIDserviceStateChanged);
     }
     if (m_HIDService){
-        qDebug() << "Current HID service state is: " << m_HIDService->state();
+        LOG_DEBUG("Current HID service state is: %1", static_cast<int>(m_HIDService->state()));
+        traceDetails(m_HIDService);
         m_HIDService->discoverDetails();
 
     }
 
+    // Device information service, tells which payload format the glove sends
+    if (!m_DeviceInfoService && wantsDeviceInfo){
+        m_DeviceInfoService = openService(QBluetoothUuid::DeviceInformation);
+    }
+    if (m_DeviceInfoService){
+        m_deviceInfoReader.attach(m_DeviceInfoService);
+        traceDetails(m_DeviceInfoService);
+        m_DeviceInfoService->discoverDetails();
+    }
+
     // Finger position service
-    if (m_foundFingerPositionService){
-        m_FingerPositionsService = m_controller->createServiceObject(QBluetoothUuid(QString("0000ff05-3333-acda-0000-ff522ee73921")));
-        connect(m_FingerPositionsService, &QLowEnergyService::stateChanged, this,  &CaptoGloveAPI::fingerPoseServiceStateChanged);
-        connect(m_FingerPositionsService, &QLowEnergyService::characteristicChanged, this, &CaptoGloveAPI::fingerPoseCharacteristicChanged);
-        connect(m_FingerPositionsService, &QLowEnergyService::descriptorWritten, this, &CaptoGloveAPI::confirmedDescriptorWrite);
+    if (!m_FingerPositionsService && m_foundFingerPositionService && m_profile.wants(CaptoGloveUuids::fingerPositionService())){
+        m_FingerPositionsService = openService(CaptoGloveUuids::fingerPositionService());
+        if (m_FingerPositionsService) {
+            connect(m_FingerPositionsService, &QLowEnergyService::stateChanged, this,  &CaptoGloveAPI::fingerPoseServiceStateChanged);
+            connect(m_FingerPositionsService, &QLowEnergyService::characteristicChanged, this, &CaptoGloveAPI::fingerPoseCharacteristicChanged);
+            // Value read by the watchdog's reread stage, delivered like a notification
+            connect(m_FingerPositionsService, &QLowEnergyService::characteristicRead, this,
+                    [this](const QLowEnergyCharacteristic &c, const QByteArray &value) {
+                if (!m_onStandby && c.uuid() == CaptoGloveUuids::fingerPositions())
+                    fingerNotification(c, value);
+            });
+            connect(m_FingerPositionsService, &QLowEnergyService::descriptorWritten, this, &CaptoGloveAPI::confirmedDescriptorWrite);
+            m_subscriptions.attach(m_FingerPositionsService);
+            m_fingerCommands.setService(m_FingerPositionsService);
+        }
     }
     if (m_FingerPositionsService)
     {
+        traceDetails(m_FingerPositionsService);
         m_FingerPositionsService->discoverDetails();
 
         m_connected = true;
     }
 
+    // Streams of services that weren't opened above won't be subscribed on this connection
+    m_subscriptions.attachDone();
+}
 
+bool CaptoGloveAPI::hasControllerError() const
+{
+    return (m_controller && m_controller->error() != QLowEnergyController::NoError);
+}
 
 
+// ############## LISTINGS ##############
+void CaptoGloveAPI::publishDevices()
+{
+    QVector<ListingRow> rows;
+    rows.reserve(m_devices.size());
+    for (const DeviceInfo *device : qAsConst(m_devices))
+        rows.append(ListingRow::device(*device));
+
+    if (m_deviceListing.publish(rows))
+        emit devicesUpdated();
 }
 
-bool CaptoGloveAPI::hasControllerError() const
+void CaptoGloveAPI::publishServices()
 {
-    return (m_controller && m_controller->error() != QLowEnergyController::NoError);
+    QVector<ListingRow> rows;
+    rows.reserve(m_services.size());
+    for (const ServiceInfo *service : qAsConst(m_services))
+        rows.append(ListingRow::service(*service));
+
+    if (m_serviceListing.publish(rows))
+        emit servicesUpdated();
+}
+
+void CaptoGloveAPI::publishCharacteristics()
+{
+    // Rows are only formatted again when the registry changed
+    if (m_characteristics.revision() == m_publishedCharacteristics)
+        return;
+    m_publishedCharacteristics = m_characteristics.revision();
+
+    const QVector<CharacteristicRecord> records = m_characteristics.records();
+    QVector<ListingRow> rows;
+    rows.reserve(records.size());
+    for (const CharacteristicRecord &record : records)
+        rows.append(ListingRow::characteristic(record));
+
+    if (m_characteristicListing.publish(rows))
+        emit characteristicsUpdated();
 }
 
 
 // ############## SERVICES ##############
-void CaptoGloveAPI::scanServices(DeviceInfo &device)        // TODO: Check why would I use address param
+void CaptoGloveAPI::releaseServices()
 {
+    m_characteristics.recycle();
+    m_advertisedServices.clear();
 
-    qDeleteAll(m_characteristics);
-    m_characteristics.clear();
-    emit characteristicsUpdated();
+    // ServiceInfo owns the service object it wraps, the members below only point into it
     qDeleteAll(m_services);
     m_services.clear();
-    emit servicesUpdated();
+
+    QLowEnergyService **services[] = { &m_batteryLevelService, &m_GAService, &m_HIDService,
+                                       &m_ScanParametersService, &m_DeviceInfoService, &m_FingerPositionsService };
+    for (QLowEnergyService **service : services)
+        *service = nullptr;
+
+    for (int span : qAsConst(m_traceDetails))
+        ConnectionTrace::instance()->end(span);
+    m_traceDetails.clear();
+}
+
+ServiceInfo *CaptoGloveAPI::serviceInfo(const QBluetoothUuid &uuid) const
+{
+    for (ServiceInfo *service : m_services) {
+        if (service->uuid() == uuid)
+            return service;
+    }
+
+    return nullptr;
+}
+
+QLowEnergyService *CaptoGloveAPI::openService(const QBluetoothUuid &uuid)
+{
+    ServiceInfo *info = serviceInfo(uuid);
+    if (!info || !m_controller)
+        return nullptr;
+    if (info->service())
+        return info->service();
+
+    QLowEnergyService *service = m_controller->createServiceObject(uuid);
+    if (!service) {
+        LOG_WARNING("Cannot create service for uuid %1", uuid.toString());
+        return nullptr;
+    }
+
+    info->setService(service);
+    publishServices();
+    return service;
+}
+
+void CaptoGloveAPI::traceDetails(QLowEnergyService *service)
+{
+    const int span = ConnectionTrace::instance()->begin(m_traceTrack, "discoverDetails", service->serviceName());
+    if (span < 0)
+        return;
+
+    // A repeated discovery replaces the span of the attempt before
+    ConnectionTrace::instance()->end(m_traceDetails.value(service, -1));
+    m_traceDetails.insert(service, span);
+    connect(service, &QLowEnergyService::stateChanged, this, &CaptoGloveAPI::detailsTraceStateChanged, Qt::UniqueConnection);
+}
+
+void CaptoGloveAPI::detailsTraceStateChanged(QLowEnergyService::ServiceState state)
+{
+    // Also ends on errors, the span shows how long the attempt blocked
+    QLowEnergyService *service = qobject_cast<QLowEnergyService *>(sender());
+    if (!service || state == QLowEnergyService::DiscoveringServices)
+        return;
+
+    ConnectionTrace::instance()->end(m_traceDetails.value(service, -1));
+    m_traceDetails.remove(service);
+}
+
+void CaptoGloveAPI::traceFirstSample()
+{
+    ConnectionTrace::instance()->end(m_traceFirstSample);
+    ConnectionTrace::instance()->instant(m_traceTrack, "firstSample");
+    m_traceFirstSample = -1;
+
+    // Startup is complete, keep the file current for every (re)connect. Written once the
+    // notification that got here has been handled
+    if (!m_traceFile.isEmpty())
+        QMetaObject::invokeMethod(this, "saveTraceFile", Qt::QueuedConnection);
+}
+
+void CaptoGloveAPI::saveTraceFile()
+{
+    saveTrace(m_traceFile);
+}
+
+void CaptoGloveAPI::startRecording()
+{
+    const QString name = QString("%1-%2").arg(m_deviceName.isEmpty() ? QString("glove") : m_deviceName)
+            .arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"));
+
+    if (!m_arrowDir.isEmpty() && !m_arrowExport.isOpen())
+        m_arrowExport.open(QDir(m_arrowDir).filePath(name + ".arrow"), m_payloadFormat->channels, m_arrowBatchRows,
+                           ArrowWriter::Background);
+
+    if (m_recordingDir.isEmpty() || m_recorder.isOpen())
+        return;
+
+    SessionHeader header;
+    header.format = QString::fromLatin1(m_payloadFormat->name);
+    header.glove = m_deviceName;
+    header.counterOffset = m_sequenceTracker.counterOffset();
+    header.counterWidth = m_sequenceTracker.counterWidth();
+
+    m_recorder.open(QDir(m_recordingDir).filePath(name + ".cgrec"), header);
+}
+
+void CaptoGloveAPI::startCalibration(const QString &glove)
+{
+    if (!m_autoCalibration || glove.isEmpty() || glove == m_calibrationGlove)
+        return;
+
+    saveCalibration();
+    m_calibrationGlove = glove;
+
+    // Saved ranges are used from the first frame on, otherwise they are learned in the warm-up
+    CalibrationProfile profile = m_handModel.calibration();
+    const QString path = QDir(m_calibrationDir).filePath(QString("%1-%2.ini").arg(m_calibrationUser).arg(glove));
+    if (!m_calibrationDir.isEmpty() && profile.load(path)) {
+        m_autoCalibrator.seed(profile);
+        LOG_INFO("Reusing calibration of %1 for %2", m_calibrationUser, glove);
+    } else {
+        m_autoCalibrator.reset();
+        LOG_INFO("Learning calibration of %1 for %2", m_calibrationUser, glove);
+    }
+
+    profile.user = m_calibrationUser;
+    profile.glove = glove;
+    m_handModel.setCalibration(profile);
+
+    if (!m_calibrationDir.isEmpty() && m_calibrationSaveTimer.interval() > 0)
+        m_calibrationSaveTimer.start();
+}
+
+void CaptoGloveAPI::publishConnection(GloveState::Connection connection)
+{
+    GloveState &latest = m_latestState.staging();
+    latest.connection = connection;
+    latest.connectionUs = m_streamClock.nsecsElapsed() / 1000;
+    m_latestState.publish();
+}
+
+void CaptoGloveAPI::publishDeviceName(const QString &name)
+{
+    qstrncpy(m_latestState.staging().deviceName, name.toUtf8().constData(), GloveState::MaxName);
+    m_latestState.publish();
+}
+
+void CaptoGloveAPI::saveCalibration() const
+{
+    if (!m_autoCalibration || m_calibrationGlove.isEmpty() || m_calibrationDir.isEmpty())
+        return;
+
+    CalibrationProfile profile = m_handModel.calibration();
+    profile.user = m_calibrationUser;
+    profile.glove = m_calibrationGlove;
+
+    QDir().mkpath(m_calibrationDir);
+    const QString path = QDir(m_calibrationDir).filePath(QString("%1-%2.ini").arg(m_calibrationUser).arg(m_calibrationGlove));
+    if (!profile.save(path))
+        LOG_WARNING("Can't save calibration profile %1", path);
+}
+
+void CaptoGloveAPI::scanServices(DeviceInfo &device)        // TODO: Check why would I use address param
+{
+
+    releaseServices();
+    publishCharacteristics();
+    publishServices();
 
     setUpdate("Back\n(Connecting to device...)");
 
@@ -270,34 +650,41 @@ void CaptoGloveAPI::scanServices(DeviceInfo &device)        // TODO: Check why w
     if (!m_controller)
     {
         QBluetoothDeviceInfo currentDevice = device.getDevice();
+        const int span = ConnectionTrace::instance()->begin(m_traceTrack, "initializeController");
         initializeController(currentDevice);
+        ConnectionTrace::instance()->end(span);
     }
 
+    m_connectTimer.start();
+    ConnectionTrace::instance()->end(m_traceConnect);
+    ConnectionTrace::instance()->end(m_traceFirstSample);
+    m_traceConnect = ConnectionTrace::instance()->begin(m_traceTrack, "connect");
+    m_traceFirstSample = ConnectionTrace::instance()->begin(m_traceTrack, "timeToFirstSample");
+    publishConnection(GloveState::Connecting);
     m_controller->connectToDevice();
 
 }
 
 void CaptoGloveAPI::connectToService(const QString &uuid)
 {
-    QLowEnergyService *service = nullptr;
-    for (auto s: qAsConst(m_services)){
-        auto serviceInfo = qobject_cast<ServiceInfo *>(s);
-        qDebug() << "Current uuid is"<< serviceInfo->getUuid();
-        if(!serviceInfo)
-            continue;
-        if (serviceInfo->getUuid() == uuid){
-            service = serviceInfo->service();
-            break;
-        }
+    // Eager services and lazy ones opened before are reused, others get their object now
+    const QBluetoothUuid serviceUuid = ServiceProfile::serviceFromString(uuid);
+    const ServiceInfo *info = serviceInfo(serviceUuid);
+    if (!info)
+        return;
+    if (!info->service() && m_profile.mode(serviceUuid) == ServiceProfile::Skip) {
+        LOG_WARNING("Service %1 is not part of the %2 profile", uuid, m_profile.name);
+        return;
     }
 
-    if(!service)
+    QLowEnergyService *service = openService(serviceUuid);
+    if (!service)
         return;
 
-
     if(service->state() == QLowEnergyService::DiscoveryRequired){
         connect(service, &QLowEnergyService::stateChanged,
-                this, &CaptoGloveAPI::serviceDetailsDiscovered);
+                this, &CaptoGloveAPI::serviceDetailsDiscovered, Qt::UniqueConnection);
+        traceDetails(service);
         service->discoverDetails();
         setUpdate("Back\n(Discovering details...)");
         return;
@@ -306,11 +693,10 @@ void CaptoGloveAPI::connectToService(const QString &uuid)
     // Discovery already done
     const QList<QLowEnergyCharacteristic> chars = service->characteristics();
     for (const QLowEnergyCharacteristic &ch : chars){
-        auto cInfo = new CharacteristicInfo(ch);
-        m_characteristics.insert(service->serviceUuid(), cInfo);
+        m_characteristics.add(service->serviceUuid(), ch);
     }
 
-    QTimer::singleShot(0, this, &CaptoGloveAPI::characteristicsUpdated);
+    QTimer::singleShot(0, this, &CaptoGloveAPI::publishCharacteristics);
 
 
 }
@@ -332,73 +718,65 @@ void CaptoGloveAPI::serviceDetailsDiscovered(QLowEnergyService::ServiceState new
 
     const QList<QLowEnergyCharacteristic> chars = service->characteristics();
     for (const QLowEnergyCharacteristic &ch : chars){
-        auto cInfo = new CharacteristicInfo(ch);
-        m_characteristics.insert(service->serviceUuid(), cInfo);
+        m_characteristics.add(service->serviceUuid(), ch);
     }
 
-    emit characteristicsUpdated();
+    publishCharacteristics();
 }
 
 void CaptoGloveAPI::addLowEnergyService(const QBluetoothUuid &uuid)
 {
-    QLowEnergyService *service = m_controller->createServiceObject(uuid);       // This part already creates service object in controller
-
-    if (!service){
-        qWarning() << "Cannot create service for uuid";
-        return;
+    // Listed right away, service objects are only created for the profile, see openService
+    LOG_DEBUG("Adding service %1", uuid.toString());
+    if (!m_advertisedServices.contains(uuid)) {
+        m_advertisedServices.append(uuid);
+        m_services.append(new ServiceInfo(uuid));
+        publishServices();
     }
-    qDebug() << "Adding service" << uuid;
-    auto serv = new ServiceInfo(service);
-    m_services.append(serv);
-
-    if(!service)
-        return;
 
     checkServiceStatus(uuid);
-
-    emit servicesUpdated();
 }
 
 void CaptoGloveAPI::checkServiceStatus(const QBluetoothUuid &uuid)
 {
 
     if (uuid == QBluetoothUuid::GenericAccess && !m_foundGAService){
-        qDebug() << "Discovered Generic Access Service!";
+        LOG_DEBUG("Discovered Generic Access Service!");
         m_foundGAService = true;
     }
 
     else if (uuid == QBluetoothUuid::BatteryService && !m_foundBatteryLevelService){
-        qDebug() << "Discovered Battery Level Service!";
+        LOG_DEBUG("Discovered Battery Level Service!");
         m_foundBatteryLevelService = true;
     }
 
     else if (uuid == QBluetoothUuid::ScanParameters && !m_foundScanParametersService){
 
-        qDebug() << "Discovered ScanParameters Service!";
+        LOG_DEBUG("Discovered ScanParameters Service!");
         m_foundScanParametersService = true;
     }
 
     else if (uuid == QBluetoothUuid::HumanInterfaceDevice && !m_foundHIDService){
 
-        qDebug() << "Discovered HID Service";
+        LOG_DEBUG("Discovered HID Service");
         m_foundHIDService = true;
     }
 
     else if (uuid == QBluetoothUuid::DeviceInformation && !m_foundDeviceInfoService)
     {
-        qDebug() << "Found Device information service.";
+        LOG_DEBUG("Found Device information service.");
         m_foundDeviceInfoService = true;
     }
 
-    else if (uuid == QBluetoothUuid(QString("0000ff05-3333-acda-0000-ff522ee73921")) && !m_foundFingerPositionService)  // Check how to use custom service!
+    else if (uuid == CaptoGloveUuids::fingerPositionService() && !m_foundFingerPositionService)
     {
-        qDebug() << "Found finger position service.";
+        LOG_DEBUG("Found finger position service.");
         m_foundFingerPositionService = true;
     }
 
     else
     {
-        qDebug() << "Service hasn't been found!";
+        LOG_DEBUG("Service hasn't been found!");
     }
 
 
@@ -407,11 +785,11 @@ void CaptoGloveAPI::checkServiceStatus(const QBluetoothUuid &uuid)
 
 void CaptoGloveAPI::serviceStateChanged(QLowEnergyService::ServiceState s)
 {
-    qDebug() << "Discovering  GA details in state: " << s ;
+    LOG_DEBUG("Discovering GA details in state: %1", static_cast<int>(s));
     switch(s){
     case QLowEnergyService::DiscoveringServices:
     {
-        qDebug() << "Discovering services...";
+        LOG_DEBUG("Discovering services...");
         break;
 
 
@@ -420,16 +798,16 @@ void CaptoGloveAPI::serviceStateChanged(QLowEnergyService::ServiceState s)
     {
             const QList<QLowEnergyCharacteristic> chars = m_batteryLevelService->characteristics();
             for (const QLowEnergyCharacteristic &ch : chars){
-                auto cInfo = new CharacteristicInfo(ch);
-                m_characteristics.insert(m_batteryLevelService->serviceUuid(), cInfo);
-                qDebug() << "Characteristic uuid is: " << cInfo->getUuid();
-                qDebug() << "Characteristic name is: " << cInfo->getName();
+                m_characteristics.add(m_batteryLevelService->serviceUuid(), ch);
+                LOG_TRACE("Characteristic uuid is: %1", ch.uuid().toString());
+                LOG_TRACE("Characteristic name is: %1", ch.name());
 
         }
+            publishCharacteristics();
     }
 
     default:
-        qDebug() << "Not wanted  state!";
+        LOG_DEBUG("Not wanted state!");
 
     emit aliveChanged();
     }
@@ -438,11 +816,11 @@ void CaptoGloveAPI::serviceStateChanged(QLowEnergyService::ServiceState s)
 // BATTERY SERVICE
 void CaptoGloveAPI::batteryServiceStateChanged(QLowEnergyService::ServiceState s)
 {
-    qDebug() << "Discovering Battery details in state: " << s ;
+    LOG_DEBUG("Discovering Battery details in state: %1", static_cast<int>(s));
     switch(s){
     case QLowEnergyService::DiscoveringServices:
     {
-        qDebug() << "Discovering services...";
+        LOG_DEBUG("Discovering services...");
         break;
 
     }
@@ -450,22 +828,22 @@ void CaptoGloveAPI::batteryServiceStateChanged(QLowEnergyService::ServiceState s
     {
         const QList<QLowEnergyCharacteristic> chars = m_batteryLevelService->characteristics();
         for (const QLowEnergyCharacteristic &ch : chars){
-            auto cInfo = new CharacteristicInfo(ch);
-            m_characteristics.insert(m_batteryLevelService->serviceUuid(), cInfo);
-            qDebug() << "Characteristic uuid is: " << cInfo->getUuid();
-            qDebug() << "Characteristic name is: " << cInfo->getName();
+            m_characteristics.add(m_batteryLevelService->serviceUuid(), ch);
+            LOG_TRACE("Characteristic uuid is: %1", ch.uuid().toString());
+            LOG_TRACE("Characteristic name is: %1", ch.name());
         }
+        publishCharacteristics();
 
 
         if (!chars.empty())
         {
             const QLowEnergyCharacteristic batteryLevelChar = m_batteryLevelService->characteristic(QBluetoothUuid::BatteryLevel);
             if (!batteryLevelChar.isValid()) {
-                qDebug("Battery level data not found.");
+                LOG_WARNING("Battery level data not found.");
                 break;
             }else{
                 m_batteryLevelService->readCharacteristic(batteryLevelChar);
-                qDebug() << "Current battery level: " << batteryLevelChar.value().toHex();
+                LOG_DEBUG("Current battery level: %1", batteryLevelChar.value());
             }
         }
 
@@ -487,17 +865,24 @@ void CaptoGloveAPI::updateBatteryLevelValue(const QLowEnergyCharacteristic &c, c
     if (c.uuid() != QBluetoothUuid(QBluetoothUuid::BatteryLevel))
         return;
 
-    auto data = reinterpret_cast<const quint8 *>(value.constData());
-    quint8 flags = *data;
+    // Battery level is a single byte in percent
+    if (value.isEmpty())
+        return;
 
-    //Heart Rate
-    int blvalue = 0;
-    if (flags & 0x1) // HR 16 bit? otherwise 8 bit
-        blvalue = static_cast<int>(qFromLittleEndian<quint16>(data[1]));
-    else
-        blvalue = static_cast<int>(data[1]);
+    const int blvalue = static_cast<quint8>(value.at(0));
+    m_batteryLevelValue = blvalue;
+    if (m_characteristics.setValue(c.handle(), value))
+        publishCharacteristics();
+
+    GloveState &latest = m_latestState.staging();
+    latest.battery = blvalue;
+    latest.batteryUs = m_streamClock.nsecsElapsed() / 1000;
+    m_latestState.publish();
+    emit updateBatteryState();
 
-    qDebug() << "Battery level is: " << blvalue;
+    m_batteryNotifications->increment();
+    m_batteryGauge->set(blvalue);
+    LOG_DEBUG("Battery level is: %1", blvalue);
 }
 
 void CaptoGloveAPI::confirmedBatteryDescWrite(const QLowEnergyDescriptor &d, const QByteArray &value)
@@ -527,11 +912,11 @@ int CaptoGloveAPI::readBatteryLevel()
 // SCAN PARAMS SERVICE
 void CaptoGloveAPI::scanParamsServiceStateChanged(QLowEnergyService::ServiceState s)
 {
-    qDebug() << "Discovering scan parameters details in state: " << s ;
+    LOG_DEBUG("Discovering scan parameters details in state: %1", static_cast<int>(s));
     switch(s){
     case QLowEnergyService::DiscoveringServices:
     {
-        qDebug() << "Discovering services...";
+        LOG_DEBUG("Discovering services...");
         break;
 
     }
@@ -539,11 +924,11 @@ void CaptoGloveAPI::scanParamsServiceStateChanged(QLowEnergyService::ServiceStat
     {
         const QList<QLowEnergyCharacteristic> chars = m_ScanParametersService->characteristics();
         for (const QLowEnergyCharacteristic &ch : chars){
-            auto cInfo = new CharacteristicInfo(ch);
-            m_characteristics.insert(m_ScanParametersService->serviceUuid(), cInfo);
-            qDebug() << "Characteristic uuid is: " << cInfo->getUuid();
-            qDebug() << "Characteristic name is: " << cInfo->getName();
+            m_characteristics.add(m_ScanParametersService->serviceUuid(), ch);
+            LOG_TRACE("Characteristic uuid is: %1", ch.uuid().toString());
+            LOG_TRACE("Characteristic name is: %1", ch.name());
         }
+        publishCharacteristics();
 
 
         if (!chars.empty())
@@ -551,7 +936,7 @@ void CaptoGloveAPI::scanParamsServiceStateChanged(QLowEnergyService::ServiceStat
             const QLowEnergyCharacteristic scanIntervalChar = m_ScanParametersService->characteristic(QBluetoothUuid::ScanIntervalWindow);
             const QLowEnergyCharacteristic scanRefreshChar = m_ScanParametersService->characteristic(QBluetoothUuid::ScanRefresh);
             if (!scanRefreshChar.isValid() || !scanIntervalChar.isValid()) {
-                qDebug("scan Interval data not found.");
+                LOG_WARNING("Scan interval data not found.");
                 break;
             }else{
                 m_ScanParametersService->readCharacteristic(scanIntervalChar);
@@ -579,7 +964,7 @@ void CaptoGloveAPI::genericAccessServiceStateChanged(QLowEnergyService::ServiceS
     {
     case QLowEnergyService::DiscoveringServices:
     {
-        qDebug() << "Discovering services...";
+        LOG_DEBUG("Discovering services...");
         break;
 
     }
@@ -587,27 +972,13 @@ void CaptoGloveAPI::genericAccessServiceStateChanged(QLowEnergyService::ServiceS
     {
         const QList<QLowEnergyCharacteristic> chars = m_GAService->characteristics();
         for (const QLowEnergyCharacteristic &ch : chars){
-            auto cInfo = new CharacteristicInfo(ch);
-            m_characteristics.insert(m_GAService->serviceUuid(), cInfo);
-            qDebug() << "Characteristic uuid is: " << cInfo->getUuid();
-            qDebug() << "Characteristic name is: " << cInfo->getName();
+            m_characteristics.add(m_GAService->serviceUuid(), ch);
+            LOG_TRACE("Characteristic uuid is: %1", ch.uuid().toString());
+            LOG_TRACE("Characteristic name is: %1", ch.name());
         }
+        publishCharacteristics();
 
-
-        if (!chars.empty())
-        {
-            const QLowEnergyCharacteristic m_deviceNameChar = m_GAService->characteristic(QBluetoothUuid::DeviceName);
-            const QLowEnergyCharacteristic m_deviceAppereance = m_GAService->characteristic(QBluetoothUuid::Appearance);
-            const QLowEnergyCharacteristic m_devicePreferredConnectionParams = m_GAService->characteristic(QBluetoothUuid::PeripheralPreferredConnectionParameters);
-            if (!m_deviceNameChar.isValid()) {
-                qDebug("Battery level data not found.");
-                break;
-            }else{
-                m_GAService->readCharacteristic(m_deviceNameChar);
-                m_deviceName = m_deviceNameChar.value().data();
-                qDebug() << "Device name is: " << m_deviceNameChar.value().data();
-            }
-        }
+        // Device name and the rest are read by m_deviceInfoReader
         break;
 
 
@@ -619,11 +990,11 @@ void CaptoGloveAPI::genericAccessServiceStateChanged(QLowEnergyService::ServiceS
 // HID SERVICE STATE CHANGE
 void CaptoGloveAPI::HIDserviceStateChanged(QLowEnergyService::ServiceState s)
 {
-    qDebug() << "Discovering HID details in state: " << s ;
+    LOG_DEBUG("Discovering HID details in state: %1", static_cast<int>(s));
     switch(s){
     case QLowEnergyService::DiscoveringServices:
     {
-        qDebug() << "Discovering HID services...";
+        LOG_DEBUG("Discovering HID services...");
         break;
 
     }
@@ -632,20 +1003,20 @@ void CaptoGloveAPI::HIDserviceStateChanged(QLowEnergyService::ServiceState s)
         QList<QBluetoothUuid> includedServices = m_HIDService->includedServices();
         const QList<QLowEnergyCharacteristic> chars = m_HIDService->characteristics();
         for (const QLowEnergyCharacteristic &ch : chars){
-            auto cInfo = new CharacteristicInfo(ch);
-            m_characteristics.insert(m_HIDService->serviceUuid(), cInfo);
-            qDebug() << "Characteristic uuid is: " << cInfo->getUuid();
-            qDebug() << "Characteristic name is: " << cInfo->getName();
+            m_characteristics.add(m_HIDService->serviceUuid(), ch);
+            LOG_TRACE("Characteristic uuid is: %1", ch.uuid().toString());
+            LOG_TRACE("Characteristic name is: %1", ch.name());
         }
+        publishCharacteristics();
 
         if (!chars.empty())
         {
-            qDebug() << "Found HID characteristics!";
+            LOG_DEBUG("Found HID characteristics!");
             }
     }
     case QLowEnergyService::InvalidService:
     {
-        qDebug() << "HID Service is invalid!";
+        LOG_WARNING("HID Service is invalid!");
         break;
     }
     default:
@@ -658,46 +1029,101 @@ void CaptoGloveAPI::HIDserviceStateChanged(QLowEnergyService::ServiceState s)
 
 }
 
+// DEVICE INFORMATION SERVICE
+void CaptoGloveAPI::setupDeviceInformation()
+{
+    m_deviceInfoReader.setTraceTrack(m_traceTrack);
+    connect(&m_deviceInfoReader, &DeviceInfoReader::finished, this, &CaptoGloveAPI::deviceInformationRead);
+    connect(&m_deviceInfoReader, &DeviceInfoReader::refreshNeeded, this, [this]() {
+        // Skipped while the cache looked valid
+        if (m_GAService && m_GAService->state() == QLowEnergyService::DiscoveryRequired) {
+            traceDetails(m_GAService);
+            m_GAService->discoverDetails();
+        }
+    });
+}
+
+void CaptoGloveAPI::deviceInformationRead(const DeviceInformation &information, bool cached)
+{
+    m_firmwareRevision = information.text(QBluetoothUuid::FirmwareRevisionString);
+    m_modelNumber = information.text(QBluetoothUuid::ModelNumberString);
+
+    const QString name = information.text(QBluetoothUuid::DeviceName);
+    if (m_deviceName.isEmpty() && !name.isEmpty()) {
+        m_deviceName = name;
+        publishDeviceName(m_deviceName);
+    }
+
+    m_deviceInformationMsg.Clear();
+    m_deviceInformationMsg.set_device_name(name.toStdString());
+    m_deviceInformationMsg.set_manufacturer_name(information.text(QBluetoothUuid::ManufacturerNameString).toStdString());
+    m_deviceInformationMsg.set_model_number(m_modelNumber.toStdString());
+    m_deviceInformationMsg.set_serial_number(information.text(QBluetoothUuid::SerialNumberString).toStdString());
+    m_deviceInformationMsg.set_hardware_revision(information.text(QBluetoothUuid::HardwareRevisionString).toStdString());
+    m_deviceInformationMsg.set_firmware_revision(m_firmwareRevision.toStdString());
+    m_deviceInformationMsg.set_software_revision(information.text(QBluetoothUuid::SoftwareRevisionString).toStdString());
+
+    LOG_INFO("Device information of %1: %2 values%3", m_peripheralDevice.getAddress(),
+             information.values.size(), cached ? QString(" (cached)") : QString());
+
+    // Read values show up in the characteristic listing
+    for (QLowEnergyService *service : { m_DeviceInfoService, m_GAService }) {
+        if (!service || service->state() != QLowEnergyService::ServiceDiscovered)
+            continue;
+        const QList<QLowEnergyCharacteristic> chars = service->characteristics();
+        for (const QLowEnergyCharacteristic &ch : chars)
+            m_characteristics.add(service->serviceUuid(), ch);
+    }
+    publishCharacteristics();
+
+    if (m_modelNumber.isEmpty())
+        LOG_INFO("Model number not found, using default payload format.");
+    selectPayloadFormat();
+}
+
+void CaptoGloveAPI::selectPayloadFormat()
+{
+    const QString name = m_payloadFormatByModel.value(m_modelNumber, m_defaultPayloadFormat);
+    const PayloadFormat *format = PayloadFormats::find(name);
+    if (!format) {
+        LOG_WARNING("Unknown payload format %1 for model %2", name, m_modelNumber);
+        format = &PayloadFormats::defaultFormat();
+    }
+
+    m_payloadFormat = format;
+    LOG_INFO("Model %1 firmware %2 uses payload format %3",
+             m_modelNumber, m_firmwareRevision, m_payloadFormat->name);
+}
+
 // FINGER SERVICE CHANGE (check characteristic changes -> F001-F004 UUIDS
 void CaptoGloveAPI::fingerPoseServiceStateChanged(QLowEnergyService::ServiceState s){
     switch(s){
     case QLowEnergyService::DiscoveringServices:
     {
-        qDebug() << "Discovering services...";
+        LOG_DEBUG("Discovering services...");
         break;
     }
     case QLowEnergyService::ServiceDiscovered:
     {
         const QList<QLowEnergyCharacteristic> chars = m_FingerPositionsService->characteristics();
         for (const QLowEnergyCharacteristic &ch : chars){
-            auto cInfo = new CharacteristicInfo(ch);
-            m_characteristics.insert(m_GAService->serviceUuid(), cInfo);
-            m_FingerPositionsService->characteristic(QBluetoothUuid(cInfo->getUuid()));
-            qDebug() << "Characteristic uuid is: " << cInfo->getUuid();
-            qDebug() << "Characteristic name is: " << cInfo->getName();
+            m_characteristics.add(m_FingerPositionsService->serviceUuid(), ch);
+            LOG_TRACE("Characteristic uuid is: %1", ch.uuid().toString());
+            LOG_TRACE("Characteristic name is: %1", ch.name());
         }
+        publishCharacteristics();
+        // Notifications are enabled by m_subscriptions
         if (!chars.empty())
-        {
-            // NOT Neccessary
-            QLowEnergyCharacteristic m_fingerReq = m_FingerPositionsService->characteristic(QBluetoothUuid(QString("0000f001-3333-acda-0000-ff522ee73921")));
-            QLowEnergyCharacteristic m_fingerFirst = m_FingerPositionsService->characteristic(QBluetoothUuid(QString("000f002-3333-acda-0000-ff522ee73921")));
-            QLowEnergyCharacteristic m_fingerSecond = m_FingerPositionsService->characteristic(QBluetoothUuid(QString("000f003-333-acda-0000-ff522ee73921")));
-            QLowEnergyCharacteristic m_fingerThird = m_FingerPositionsService->characteristic(QBluetoothUuid(QString("000f004-333-acda-0000-ff522ee73921")));
-
-            QLowEnergyDescriptor desc = m_fingerSecond.descriptor(QBluetoothUuid::ClientCharacteristicConfiguration);
-            m_FingerPositionsService->writeDescriptor(desc, QByteArray::fromHex("0100"));
-
             emit initialized();
-        }
         break;
     }
     case QLowEnergyService::InvalidService:
     {
-        qDebug() << "Finger service is invalid! ";
+        LOG_WARNING("Finger service is invalid!");
         break;
     }
     default:
-        qDebug() << "Default in switch";
+        LOG_DEBUG("Default in switch");
 
 
 }
@@ -706,54 +1132,162 @@ void CaptoGloveAPI::fingerPoseServiceStateChanged(QLowEnergyService::ServiceStat
 
 void CaptoGloveAPI::fingerPoseCharacteristicChanged(const QLowEnergyCharacteristic &c, const QByteArray &value){
 
-    // Read current characteristic value
-    m_FingerPositionsService->readCharacteristic(c);
+    // After a failover this glove is the standby, its samples only show that it is alive
+    if (m_onStandby) {
+        if (c.uuid() != CaptoGloveUuids::fingerPositions())
+            return;
+        m_primaryLastUs = m_streamClock.nsecsElapsed() / 1000;
+
+        // The spare stopped delivering, take over with this very sample
+        if (m_watchdog.stage() == StreamWatchdog::Watching || !failover(QStringLiteral("standby stall")))
+            return;
+    }
 
-    // Set current finger value
-    m_currentFingerPosition = c.value();
+    fingerNotification(c, value);
+}
 
-    qDebug() << "Fingers value is: " << m_currentFingerPosition;
+void CaptoGloveAPI::fingerNotification(const QLowEnergyCharacteristic &c, const QByteArray &value)
+{
+    if (!m_imuCharacteristic.isNull() && c.uuid() == m_imuCharacteristic)
+    {
+        imuCharacteristicChanged(value);
+        return;
+    }
 
-    if (c.uuid() == QBluetoothUuid(QString("000f001-3333-acda-0000-ff522ee73921")))
+    if (c.uuid() != CaptoGloveUuids::fingerPositions())
     {
-        qDebug() << "Characteristic f001 changed!" ;
+        LOG_TRACE("Characteristic %1 changed!", static_cast<quint64>(c.handle()));
+        return;
     }
 
-    if (c.uuid() == QBluetoothUuid(QString("000f002-3333-acda-0000-ff522ee73921")))
+    injectFingerPayload(value);
+}
 
-    {
-        qDebug() << "Characteristic f002 changed!";
+void CaptoGloveAPI::injectFingerPayload(const QByteArray &value)
+{
+    // Steady state path, meant not to allocate. Not yet confirmed by a --alloc-check run (see allocationcheck.h)
+    // Set current finger value from notification payload
+    m_currentFingerPosition = value;
+
+    const qint64 now = m_streamClock.nsecsElapsed() / 1000;
+    m_fingerNotifications->increment();
+    m_watchdog.feed();
+    if (m_traceFirstSample >= 0)
+        traceFirstSample();
+
+    // First sample of the new source completes a failover
+    const bool sourceChanged = m_failoverUs > 0;
+    if (sourceChanged) {
+        const double switchMs = (now - m_failoverUs) / 1000.0;
+        m_failoverSwitch->observe(switchMs);
+        if (m_lastFingerUs > 0)
+            m_failoverGap->observe((now - m_lastFingerUs) / 1000.0);
+        m_failoverUs = 0;
+        LOG_INFO("%1 delivers %2 ms after the failover", getActiveGlove(), switchMs);
+    }
+    if (m_recorder.isOpen())
+        m_recorder.append(now, reinterpret_cast<const uchar *>(value.constData()), value.size());
+    if (m_lastFingerUs > 0)
+        m_notificationInterval->observe((now - m_lastFingerUs) / 1000.0);
+    m_lastFingerUs = now;
+
+    LOG_TRACE("Fingers value is: %1", m_currentFingerPosition);
+
+    FingerFrame frame;
+    frame.timestampUs = now;
+    const uchar *data = reinterpret_cast<const uchar *>(value.constData());
+    uchar scratch[SequenceTracker::MaxPayload];
+    int dataSize = value.size();
+    const uchar *channels = m_sequenceTracker.channelData(data, dataSize, scratch);
+    if (!m_payloadFormat->decode(channels, dataSize, frame)) {
+        m_decodeErrors->increment();
+        LOG_WARNING("Finger payload of %1 bytes doesn't fit format %2", value.size(), m_payloadFormat->name);
+        return;
     }
 
-    if (c.uuid() == QBluetoothUuid(QString("000f003-3333-acda-0000-ff522ee73921")))
-    {
-        qDebug() << "Characteristic f003 changed!";
+    if (m_hasOrientation) {
+        for (int k = 0; k < 4; ++k)
+            frame.orientation[k] = m_orientationFilter.quaternion()[k];
+        frame.flags |= FingerFrame::HasOrientation;
+    }
+    if (sourceChanged)
+        frame.flags |= FingerFrame::SourceChanged;
 
+    const int missing = m_sequenceTracker.track(data, value.size(), frame);
+    if (missing < 0) {
+        m_duplicateFrames->increment();
+        LOG_DEBUG("Dropping duplicate finger sample %1", frame.sequence);
+        return;
     }
 
-    if (c.uuid() == QBluetoothUuid(QString("000f004-3333-acda-0000-ff522ee73921")))
-    {
-        qDebug() << "Characteristic f004 changed!";
+    if (missing > 0) {
+        m_droppedFrames->increment(static_cast<quint64>(missing));
+        LOG_DEBUG("Lost %1 finger samples before %2", missing, frame.sequence);
+        emit gapDetected(frame.sequence - static_cast<quint64>(missing), missing);
+
+        const int filled = m_sequenceTracker.fill(frame, missing, m_gapFill, MaxGapFill);
+        for (int i = 0; i < filled; ++i)
+            emit frameReceived(m_gapFill[i]);
     }
 
-    emit updateFingerState();
+    m_currentFrame = frame;
+    emit frameReceived(frame);
+
+    if (m_autoCalibration) {
+        m_autoCalibrator.update(frame);
+        m_handModel.setRanges(m_autoCalibrator.minimum(), m_autoCalibrator.maximum(), m_autoCalibrator.rest());
+    }
+    m_handModel.evaluate(frame, m_currentPose);
+
+    GloveState &latest = m_latestState.staging();
+    latest.frame = frame;
+    latest.pose = m_currentPose;
+    latest.payloadSize = qMin(value.size(), static_cast<int>(GloveState::MaxPayload));
+    memcpy(latest.payload, value.constData(), static_cast<size_t>(latest.payloadSize));
+    m_latestState.publish();
+
+    emit poseUpdated(m_currentPose);
 
+    if (m_arrowExport.isOpen())
+        m_arrowExport.append(frame, m_currentPose, m_batteryLevelValue);
+
+}
+
+void CaptoGloveAPI::imuCharacteristicChanged(const QByteArray &value)
+{
+    const qint64 now = m_streamClock.nsecsElapsed() / 1000;
+    m_imuNotifications->increment();
+    const int count = decodeImuPayload(reinterpret_cast<const uchar *>(value.constData()), value.size(),
+                                       m_accelScale, m_gyroScale, m_lastImuUs, now,
+                                       m_imuSamples, MaxImuSamples);
+    m_lastImuUs = now;
+    if (count == 0) {
+        m_decodeErrors->increment();
+        return;
+    }
+
+    m_orientationFilter.update(m_imuSamples, count);
+    m_hasOrientation = true;
 }
 
 void CaptoGloveAPI::confirmedDescriptorWrite(const QLowEnergyDescriptor &d, const QByteArray &value){
 
-    qDebug() << "Written descriptor!!!";
+    LOG_DEBUG("Written descriptor %1", value);
 }
 
 void CaptoGloveAPI::setFingerMsg()
 {
 
-    // TODO: transform to valid datta format currentFingerPosition
-    m_fingerFeedbackMsg.set_thumb_finger(m_currentFingerPosition.at(0));
-    m_fingerFeedbackMsg.set_index_finger(m_currentFingerPosition.at(1));
-    m_fingerFeedbackMsg.set_middle_finger(m_currentFingerPosition.at(2));
-    m_fingerFeedbackMsg.set_ring_finger(m_currentFingerPosition.at(4));
-    m_fingerFeedbackMsg.set_thumb_finger(m_currentFingerPosition.at(5));
+    // Channels are already decoded for the connected glove's payload format
+    const FingerFrame &frame = m_currentFrame;
+    if (frame.channelCount < HandPose::FingerCount)
+        return;
+
+    m_fingerFeedbackMsg.set_thumb_finger(frame.channels[m_handModel.channel(HandPose::Thumb, frame.channelCount)]);
+    m_fingerFeedbackMsg.set_index_finger(frame.channels[m_handModel.channel(HandPose::Index, frame.channelCount)]);
+    m_fingerFeedbackMsg.set_middle_finger(frame.channels[m_handModel.channel(HandPose::Middle, frame.channelCount)]);
+    m_fingerFeedbackMsg.set_ring_finger(frame.channels[m_handModel.channel(HandPose::Ring, frame.channelCount)]);
+    m_fingerFeedbackMsg.set_little_finger(frame.channels[m_handModel.channel(HandPose::Little, frame.channelCount)]);
 
 }
 
@@ -767,25 +1301,47 @@ void CaptoGloveAPI::startConnection(){
 
 
 
-    QString choosenDevice("CaptoGlove3148");
+    const QString choosenDevice = m_wantedDevice;
+
+    ConnectionTrace::instance()->end(m_traceDiscovery);
+    m_traceDiscovery = -1;
 
     DeviceInfo *m_devicePtr;
     // TODO: Think of stopping if haven't discovered / connected to wanted device
     foreach(m_devicePtr, m_devices)
     {
-        qDebug() << QString("Current device: %1").arg(m_devicePtr->getName());
+        LOG_DEBUG("Current device: %1", m_devicePtr->getName());
 
         if (m_devicePtr->getName().contains(choosenDevice))
         {
             m_peripheralDevice.setDevice(m_devicePtr->getDevice());
+            m_deviceName = m_devicePtr->getName();     // Generic Access may not be read with a minimal profile
+            m_metrics.setCommonLabels(MetricsRegistry::label("glove", m_devicePtr->getName()));
+            m_rssiGauge->set(m_devicePtr->getDevice().rssi());
+            m_latestState.staging().rssi = m_devicePtr->getDevice().rssi();
+            publishDeviceName(m_deviceName);
+            ConnectionTrace::instance()->setTrackName(m_traceTrack, QString("%1 %2").arg(m_devicePtr->getName())
+                                                      .arg(m_devicePtr->getAddress()));
             break;
         }else{
 
-            qDebug() << "Wanted Peripheral is not found!";
+            LOG_DEBUG("Wanted Peripheral is not found!");
             // TODO: Add error handling if device hasn't been found
         }
     }
 
+    startCalibration(m_deviceName);
+
+    // Hot standby is connected next to the primary and stays armed
+    if (!m_standbyDevice.isEmpty() && !m_standby.isArmed()) {
+        for (DeviceInfo *device : qAsConst(m_devices)) {
+            if (device->getName().contains(m_standbyDevice) && device->getName() != m_deviceName) {
+                m_standby.connectTo(device->getDevice(), isRandomAddress());
+                break;
+            }
+        }
+    }
+
     // Start Service discovery
     scanServices(m_peripheralDevice); // TODO: Maybe break controller initialization and scanning for services in two method calls
 
@@ -799,15 +1355,15 @@ void CaptoGloveAPI::startConnection(){
 }
 
 void CaptoGloveAPI::run(){
-    qDebug() << "Starting device discovery";
+    LOG_INFO("Starting device discovery");
     startDeviceDiscovery();
 }
 // SWAP processLoop with measuring change! --> redundant with good signals and slot logic!
 void CaptoGloveAPI::processLoop(){
 
-    qDebug() << "Entered process loop!";
+    LOG_DEBUG("Entered process loop!");
     QThread::msleep(1000);
-    qDebug() << getFingers();
+    LOG_DEBUG("Fingers: %1", getFingers());
     /*while(true)
     {
         QThread::msleep(1000);
@@ -829,28 +1385,25 @@ void CaptoGloveAPI::processLoop(){
 
 QByteArray CaptoGloveAPI::getFingers()
 {
-    QLowEnergyCharacteristic m_fingerZero =  m_FingerPositionsService->characteristic(QBluetoothUuid(QString("0000f001-3333-acda-0000-ff522ee73921")));
-    QLowEnergyCharacteristic m_fingerFirst = m_FingerPositionsService->characteristic(QBluetoothUuid(QString("0000f002-3333-acda-0000-ff522ee73921")));
-    QLowEnergyCharacteristic m_fingerSecond = m_FingerPositionsService->characteristic(QBluetoothUuid(QString("0000f003-3333-acda-0000-ff522ee73921")));
-    QLowEnergyCharacteristic m_fingerThird = m_FingerPositionsService->characteristic(QBluetoothUuid(QString("0000f004-3333-acda-0000-ff522ee73921")));
+    QLowEnergyCharacteristic m_fingerZero =  m_FingerPositionsService->characteristic(CaptoGloveUuids::fingerCommand());
+    QLowEnergyCharacteristic m_fingerFirst = m_FingerPositionsService->characteristic(CaptoGloveUuids::fingerF002());
+    QLowEnergyCharacteristic m_fingerSecond = m_FingerPositionsService->characteristic(CaptoGloveUuids::fingerPositions());
+    QLowEnergyCharacteristic m_fingerThird = m_FingerPositionsService->characteristic(CaptoGloveUuids::fingerF004());
 
-    m_FingerPositionsService->writeCharacteristic(m_fingerZero, QByteArray("83"));
+    writeCommand(CaptoGloveUuids::fingerCommand(), QByteArray("83"));
     m_FingerPositionsService->readCharacteristic(m_fingerFirst);
     m_FingerPositionsService->readCharacteristic(m_fingerSecond); // DOES NOT CHANGE?!
     m_FingerPositionsService->readCharacteristic(m_fingerThird);
 
-    QLowEnergyDescriptor desc = m_fingerSecond.descriptor(QBluetoothUuid::ClientCharacteristicConfiguration);
-    m_FingerPositionsService->writeDescriptor(desc, QByteArray::fromHex("0100"));
-
     // Find out properties
-    qDebug() << "Properties for zero:" << m_fingerZero.properties();
-    qDebug() << "Properties for first: " << m_fingerFirst.properties();
-    qDebug() << "Properties for second:" << m_fingerSecond.properties();
-    qDebug() << "Properties for third:" << m_fingerThird.properties();
+    LOG_TRACE("Properties for zero: %1", static_cast<int>(m_fingerZero.properties()));
+    LOG_TRACE("Properties for first: %1", static_cast<int>(m_fingerFirst.properties()));
+    LOG_TRACE("Properties for second: %1", static_cast<int>(m_fingerSecond.properties()));
+    LOG_TRACE("Properties for third: %1", static_cast<int>(m_fingerThird.properties()));
 
-    qDebug() << "m_fingerFirst" << m_fingerFirst.value();
-    qDebug() << "m_fingerSecond" << m_fingerSecond.value();
-    qDebug() << "m_fingerThird" << m_fingerThird.value();
+    LOG_TRACE("m_fingerFirst %1", m_fingerFirst.value());
+    LOG_TRACE("m_fingerSecond %1", m_fingerSecond.value());
+    LOG_TRACE("m_fingerThird %1", m_fingerThird.value());
 
     return m_fingerSecond.value();
 }
@@ -864,32 +1417,12 @@ void CaptoGloveAPI::setUpdate(const QString &message)
 void CaptoGloveAPI::discoverServices()
 {
 
-    QList<bool> discoveredList;
-    ServiceInfo *srvPtr;
-        foreach(srvPtr, m_services)
-        {
-            QLowEnergyService* serv = srvPtr->service();
-            QBluetoothUuid uuid = QBluetoothUuid(srvPtr->getUuid());
-            if(serv->state() != QLowEnergyService::ServiceDiscovered){
-                discoveredList.append(false);
-                serv->discoverDetails();
-            }else{
-                m_controller->createServiceObject(uuid);
-                discoveredList.append(true);
-            }
-
-
-        }
-
-        if(!discoveredList.contains(false)){
-            m_discoveredServices = false;
-            discoverServices();
-        }
-        else{
-            qDebug() << "Discovered all found services!";
-            m_discoveredServices = true;
-            emit servicesDiscovered();
-        }
+    // Detail discovery only runs for the services of the profile, see serviceScanDone
+    LOG_DEBUG("Discovered all found services!");
+    ConnectionTrace::instance()->end(m_traceServices);
+    m_traceServices = -1;
+    m_discoveredServices = true;
+    emit servicesDiscovered();
 
 }
 
@@ -917,40 +1450,521 @@ void CaptoGloveAPI::loadSettings(QString path){
     //Setting.endGroup();
 
     //m_controlSystem->readParameters(&Setting);
+
+    Setting.beginGroup("InitialSetup");
+    m_wantedDevice = Setting.value("deviceName", m_wantedDevice).toString();
+    Setting.endGroup();
+
+    // Log level and destination, stderr if no file is given
+    Setting.beginGroup("Logger");
+    Logger::instance()->setLevel(Logger::levelFromString(Setting.value("level", "debug").toString()));
+    Logger::instance()->setOutputFile(Setting.value("file").toString());
+    Setting.endGroup();
+
+    // Sample stream gap handling
+    Setting.beginGroup("Stream");
+    m_sequenceTracker.setCounter(Setting.value("counterOffset", -1).toInt(),
+                                 Setting.value("counterWidth", 1).toInt());
+    m_sequenceTracker.setFillPolicy(SequenceTracker::fillPolicyFromString(Setting.value("fillPolicy", "none").toString()));
+    m_sequenceTracker.setMaxFill(qMin(Setting.value("maxFill", 8).toInt(), static_cast<int>(MaxGapFill)));
+    Setting.endGroup();
+
+    // Payload format per model number from the Device Information service
+    Setting.beginGroup("Decoder");
+    m_payloadFormatByModel.clear();
+    const QStringList models = Setting.childKeys();
+    for (const QString &model : models)
+        m_payloadFormatByModel.insert(model, Setting.value(model).toString());
+    m_defaultPayloadFormat = m_payloadFormatByModel.take("default");
+    if (m_defaultPayloadFormat.isEmpty())
+        m_defaultPayloadFormat = PayloadFormats::defaultFormat().name;
+    Setting.endGroup();
+
+    // Inertial characteristic and its scaling
+    Setting.beginGroup("Imu");
+    const QString imuCharacteristic = Setting.value("characteristic").toString();
+    m_imuCharacteristic = imuCharacteristic.isEmpty() ? QBluetoothUuid() : QBluetoothUuid(imuCharacteristic);
+    m_accelScale = Setting.value("accelScale", 1.0 / 16384.0).toFloat();
+    m_gyroScale = Setting.value("gyroScale", 1.0 / 16.4).toFloat() * 3.14159265f / 180.0f;
+    m_orientationFilter.setBeta(Setting.value("beta", 0.1).toFloat());
+    Setting.endGroup();
+
+    // Finger channels and calibration of the hand model
+    Setting.beginGroup("HandModel");
+    const QStringList channels = Setting.value("channels").toStringList();
+    if (channels.size() == HandPose::FingerCount) {
+        int fingerChannels[HandPose::FingerCount];
+        for (int f = 0; f < HandPose::FingerCount; ++f)
+            fingerChannels[f] = channels.at(f).toInt();
+        m_handModel.setChannels(fingerChannels);
+    }
+    const QString profile = Setting.value("profile").toString();
+    if (!profile.isEmpty())
+        loadCalibrationProfile(profile);
+    Setting.endGroup();
+
+    // Ranges and rest pose learned while streaming, the profile above only contributes the response curves then
+    Setting.beginGroup("Calibration");
+    m_autoCalibration = Setting.value("auto", m_autoCalibration).toBool();
+    m_calibrationUser = Setting.value("user", m_calibrationUser).toString();
+    m_calibrationDir = Setting.value("dir", "calibration").toString();
+    if (!m_calibrationDir.isEmpty() && QDir::isRelativePath(m_calibrationDir))
+        m_calibrationDir = QDir(QFileInfo(path).absolutePath()).filePath(m_calibrationDir);
+    m_calibrationSaveTimer.setInterval(Setting.value("saveSeconds", 60).toInt() * 1000);
+    AutoCalibrator::Settings calibration;
+    calibration.warmupSeconds = Setting.value("warmupSeconds", calibration.warmupSeconds).toFloat();
+    calibration.rate = Setting.value("rate", calibration.rate).toFloat();
+    calibration.minSpan = Setting.value("minSpan", calibration.minSpan).toFloat();
+    m_autoCalibrator.setSettings(calibration);
+    Setting.endGroup();
+
+    // Publish policy for updateFingerState and the default one of added subscribers
+    Setting.beginGroup("Publish");
+    PublishPolicy publishPolicy = PublishPolicy::fromString(Setting.value("deadband", "0").toString(),
+                                                            Setting.value("changeOnly", true).toBool(),
+                                                            Setting.value("maxRateHz", 0.0).toDouble());
+    publishPolicy.backpressure = PublishPolicy::backpressureFromString(Setting.value("backpressure", "unbounded").toString());
+    publishPolicy.queueDepth = Setting.value("queueDepth", publishPolicy.queueDepth).toInt();
+    m_subscriberPolicy = publishPolicy;
+    // updateFingerState receivers run on this thread, backpressure only applies behind a thread boundary
+    publishPolicy.backpressure = PublishPolicy::Unbounded;
+    m_fingerStatePublisher.setPolicy(publishPolicy);
+    Setting.endGroup();
+
+    // Services to set up on connect, minimal or full or lists of service names/uuids
+    Setting.beginGroup("Profile");
+    m_profile = ServiceProfile::fromStrings(Setting.value("name", "minimal").toString(),
+                                            Setting.value("eager").toStringList(),
+                                            Setting.value("lazy").toStringList());
+    Setting.endGroup();
+
+    // Command writes, credits are spent per connection interval
+    Setting.beginGroup("Commands");
+    m_fingerCommands.setCredits(Setting.value("creditsPerInterval", 2).toInt());
+    m_fingerCommands.setMaxDepth(Setting.value("maxDepth", 32).toInt());
+    Setting.endGroup();
+
+    // Stall detection of the finger stream
+    Setting.beginGroup("Watchdog");
+    StreamWatchdog::Settings watchdog;
+    watchdog.missedIntervals = Setting.value("missedIntervals", watchdog.missedIntervals).toInt();
+    watchdog.minStallMs = Setting.value("minStallMs", watchdog.minStallMs).toInt();
+    watchdog.checkMs = Setting.value("checkMs", watchdog.checkMs).toInt();
+    watchdog.stageMs = Setting.value("stageMs", watchdog.stageMs).toInt();
+    watchdog.maxReconnectMs = Setting.value("maxReconnectMs", watchdog.maxReconnectMs).toInt();
+    m_watchdog.setSettings(watchdog);
+    Setting.endGroup();
+
+    // Second glove kept connected to take over the stream
+    Setting.beginGroup("Failover");
+    m_standbyDevice = Setting.value("standbyDevice").toString();
+    m_standby.setRetryMs(Setting.value("retryMs", 1000).toInt());
+    Setting.endGroup();
+
+    // Chrome trace of discovery, connect and GATT setup, written once samples flow
+    Setting.beginGroup("Trace");
+    m_traceFile = Setting.value("file").toString();
+    ConnectionTrace::instance()->setEnabled(!m_traceFile.isEmpty() || ConnectionTrace::instance()->isEnabled());
+    Setting.endGroup();
+
+    // Raw notifications for offline analysis (--analyze)
+    Setting.beginGroup("Recording");
+    m_recordingDir = Setting.value("dir").toString();
+    Setting.endGroup();
+
+    // Decoded columns for pandas/Polars, Arrow IPC file per connection
+    Setting.beginGroup("Export");
+    m_arrowDir = Setting.value("arrowDir").toString();
+    m_arrowBatchRows = Setting.value("batchRows", m_arrowBatchRows).toInt();
+    Setting.endGroup();
+
+    // Prometheus export, to a text file and/or a local scrape port
+    Setting.beginGroup("Metrics");
+    m_metrics.setExportFile(Setting.value("file").toString(), Setting.value("intervalMs", 5000).toInt());
+    const int metricsPort = Setting.value("port", 0).toInt();
+    if (metricsPort > 0)
+        m_metrics.listen(static_cast<quint16>(metricsPort));
+    Setting.endGroup();
+}
+
+
+// ############## SUBSCRIPTIONS ##############
+void CaptoGloveAPI::setupSubscriptions()
+{
+    m_subscriptions.clear();
+    m_subscriptions.subscribe(CaptoGloveUuids::fingerPositionService(), CaptoGloveUuids::fingerPositions());
+    m_subscriptions.subscribe(QBluetoothUuid(QBluetoothUuid::BatteryService), QBluetoothUuid(QBluetoothUuid::BatteryLevel));
+
+    // Inertial stream, only if configured
+    if (!m_imuCharacteristic.isNull())
+        m_subscriptions.subscribe(CaptoGloveUuids::fingerPositionService(), m_imuCharacteristic);
+}
+
+
+// ############## WATCHDOG ##############
+void CaptoGloveAPI::setupWatchdog()
+{
+    // Data is expected once the finger stream is subscribed
+    connect(&m_subscriptions, &SubscriptionManager::subscribed, this, [this](const QBluetoothUuid &characteristic) {
+        if (characteristic != CaptoGloveUuids::fingerPositions() || m_onStandby)
+            return;
+        m_watchdog.arm();
+        publishConnection(GloveState::Streaming);
+        emit aliveChanged();
+    });
+
+    connect(&m_watchdog, &StreamWatchdog::stallDetected, this, [this](qint64) {
+        m_stalls->increment();
+
+        // A streaming standby takes over at once, the stalled glove reconnects to become the next standby
+        if (failover(QStringLiteral("stall"))) {
+            if (m_onStandby)
+                disconnectFromDevice();
+            else
+                m_standby.reconnect();
+        } else {
+            publishConnection(GloveState::Stalled);
+        }
+        emit aliveChanged();
+    });
+    connect(&m_watchdog, &StreamWatchdog::recovered, this, [this](qint64 detectMs, qint64 recoverMs, StreamWatchdog::Stage) {
+        m_stallDetect->observe(detectMs);
+        m_stallRecover->observe(recoverMs);
+        publishConnection(GloveState::Streaming);
+        emit aliveChanged();
+    });
+
+    // Recovery steps, cheapest first, on whichever glove delivers
+    connect(&m_watchdog, &StreamWatchdog::resubscribeRequested, this, [this]() {
+        if (m_onStandby)
+            m_standby.reapply();
+        else
+            m_subscriptions.reapply(CaptoGloveUuids::fingerPositions());
+    });
+    connect(&m_watchdog, &StreamWatchdog::rereadRequested, this, [this]() {
+        if (!m_onStandby && m_FingerPositionsService && m_FingerPositionsService->state() == QLowEnergyService::ServiceDiscovered)
+            m_FingerPositionsService->readCharacteristic(m_FingerPositionsService->characteristic(CaptoGloveUuids::fingerPositions()));
+    });
+    connect(&m_watchdog, &StreamWatchdog::reconnectRequested, this, [this]() {
+        if (m_onStandby)
+            m_standby.reconnect();
+        else
+            disconnectFromDevice();
+    });
+}
+
+
+// ############## FAILOVER ##############
+void CaptoGloveAPI::setupFailover()
+{
+    QList<QBluetoothUuid> characteristics;
+    characteristics << CaptoGloveUuids::fingerPositions();
+    if (!m_imuCharacteristic.isNull())
+        characteristics << m_imuCharacteristic;
+    m_standby.setCharacteristics(characteristics);
+
+    // Only emitted while the spare is the active source, same path as the primary's samples
+    connect(&m_standby, &StandbyLink::notified, this, &CaptoGloveAPI::fingerNotification);
+
+    // Spare lost while delivering, back to this glove if it streams
+    connect(&m_standby, &StandbyLink::lost, this, [this]() {
+        if (m_onStandby)
+            failover(QStringLiteral("standby disconnect"));
+    });
+}
+
+bool CaptoGloveAPI::failover(const QString &reason)
+{
+    if (m_standbyDevice.isEmpty())
+        return false;
+
+    // Only to a glove whose samples are arriving right now
+    const qint64 now = m_streamClock.nsecsElapsed() / 1000;
+    const qint64 thresholdMs = m_watchdog.stallThresholdMs();
+    const bool ready = m_onStandby ? m_primaryLastUs > 0 && (now - m_primaryLastUs) / 1000 < thresholdMs
+                                   : m_standby.isStreaming(thresholdMs);
+    if (!ready) {
+        LOG_WARNING("No streaming standby glove to take over after %1", reason);
+        return false;
+    }
+
+    const QString from = getActiveGlove();
+    m_onStandby = !m_onStandby;
+    m_standby.setDelivering(m_onStandby);
+    m_primaryLastUs = 0;
+
+    // Counter, cadence and orientation belong to the other glove, sequence numbers go on
+    m_sequenceTracker.handover();
+    m_orientationFilter.reset();
+    m_hasOrientation = false;
+    m_lastImuUs = 0;
+
+    m_failoverUs = now;
+    m_failovers->increment();
+    publishDeviceName(getActiveGlove());
+    ConnectionTrace::instance()->instant(m_traceTrack, "failover", reason);
+    LOG_WARNING("Failover from %1 to %2 after %3", from, getActiveGlove(), reason);
+    emit failedOver(from, getActiveGlove(), reason);
+    return true;
+}
+
+
+// ############## METRICS ##############
+void CaptoGloveAPI::setupMetrics()
+{
+    m_fingerNotifications = m_metrics.counter("captoglove_notifications_total", "Notifications received per characteristic",
+                                              MetricsRegistry::label("characteristic", "finger"));
+    m_imuNotifications = m_metrics.counter("captoglove_notifications_total", "Notifications received per characteristic",
+                                           MetricsRegistry::label("characteristic", "imu"));
+    m_batteryNotifications = m_metrics.counter("captoglove_notifications_total", "Notifications received per characteristic",
+                                               MetricsRegistry::label("characteristic", "battery"));
+    m_decodeErrors = m_metrics.counter("captoglove_decode_errors_total", "Payloads that did not fit the decoder");
+    m_droppedFrames = m_metrics.counter("captoglove_dropped_frames_total", "Finger samples lost on the link");
+    m_duplicateFrames = m_metrics.counter("captoglove_duplicate_frames_total", "Finger samples received twice");
+    m_reconnects = m_metrics.counter("captoglove_reconnects_total", "Reconnect attempts after a disconnect");
+    m_stalls = m_metrics.counter("captoglove_stalls_total", "Finger stream stalls while connected");
+    m_failovers = m_metrics.counter("captoglove_failovers_total", "Switches of the output stream between primary and standby glove");
+    m_subscriberDropped = m_metrics.counter("captoglove_subscriber_dropped_total", "Frames discarded by the backpressure policy of all frame subscribers");
+    m_fingerStatePublisher.setDropCounter(m_subscriberDropped);
+
+    m_connectionIntervalGauge = m_metrics.gauge("captoglove_connection_interval_ms", "Negotiated connection interval");
+    m_connectTimeGauge = m_metrics.gauge("captoglove_connect_time_ms", "Time from connecting until all streams were live");
+    m_rssiGauge = m_metrics.gauge("captoglove_rssi_dbm", "Signal strength seen at discovery");
+    m_batteryGauge = m_metrics.gauge("captoglove_battery_percent", "Last reported battery level");
+    m_publishQueueGauge = m_metrics.gauge("captoglove_publish_queue_depth", "Frames held by all frame subscribers");
+    m_subscriberQueueGauge = m_metrics.gauge("captoglove_subscriber_queue_max", "Deepest delivery queue of all frame subscribers");
+    m_writeQueueGauge = m_metrics.gauge("captoglove_write_queue_depth", "Commands waiting for the finger service");
+    m_logDroppedGauge = m_metrics.gauge("captoglove_log_dropped", "Log records dropped on full rings");
+
+    m_notificationInterval = m_metrics.histogram("captoglove_notification_interval_ms", "Time between finger notifications",
+                                                 QList<double>() << 5 << 7.5 << 10 << 15 << 20 << 30 << 50 << 100 << 250 << 1000);
+    m_writeLatency = m_metrics.histogram("captoglove_write_latency_ms", "Time from queueing a command to its write",
+                                         QList<double>() << 1 << 5 << 10 << 20 << 50 << 100 << 250 << 1000);
+    m_stallDetect = m_metrics.histogram("captoglove_stall_detect_ms", "Time from the last sample until a stall was declared",
+                                        QList<double>() << 50 << 100 << 200 << 500 << 1000 << 2000);
+    m_stallRecover = m_metrics.histogram("captoglove_stall_recover_ms", "Time from declaring a stall until samples arrived again",
+                                         QList<double>() << 100 << 250 << 500 << 1000 << 2500 << 5000 << 10000 << 30000);
+    m_failoverSwitch = m_metrics.histogram("captoglove_failover_switch_ms", "Time from a failover until the new glove delivered",
+                                           QList<double>() << 1 << 2.5 << 5 << 10 << 20 << 50 << 100 << 250 << 1000);
+    m_failoverGap = m_metrics.histogram("captoglove_failover_gap_ms", "Output gap between the last sample of the failed glove and the first of the new one",
+                                        QList<double>() << 10 << 25 << 50 << 100 << 250 << 500 << 1000 << 5000);
+    connect(&m_fingerCommands, &WriteQueue::commandWritten, this, [this](const QBluetoothUuid &, double latencyMs) {
+        m_writeLatency->observe(latencyMs);
+    });
+
+    m_metrics.addCollector([this]() { collectMetrics(); });
+}
+
+Histogram *CaptoGloveAPI::connectTimeHistogram()
+{
+    // Profiles are compared by running with each, the histogram is labelled with the one in use
+    Histogram *&histogram = m_connectTimes[m_profile.name];
+    if (!histogram)
+        histogram = m_metrics.histogram("captoglove_connect_duration_ms", "Time from connecting until all streams were live per service profile",
+                                        QList<double>() << 250 << 500 << 1000 << 1500 << 2000 << 3000 << 5000 << 10000 << 30000,
+                                        MetricsRegistry::label("profile", m_profile.name));
+    return histogram;
+}
+
+void CaptoGloveAPI::collectMetrics()
+{
+    // Cold values, sampled only when metrics are exported
+    QList<const FrameSubscriber *> subscribers;
+    subscribers.append(&m_fingerStatePublisher);
+    for (const FrameSubscriber *subscriber : findChildren<FrameSubscriber *>())
+        subscribers.append(subscriber);
+
+    int pending = 0;
+    int deepest = 0;
+    for (const FrameSubscriber *subscriber : subscribers) {
+        pending += subscriber->pending();
+        deepest = qMax(deepest, subscriber->queued());
+    }
+    m_publishQueueGauge->set(pending);
+    m_subscriberQueueGauge->set(deepest);
+    m_writeQueueGauge->set(m_fingerCommands.depth());
+    m_logDroppedGauge->set(static_cast<double>(Logger::instance()->dropped()));
 }
 
 
 // ############## GETTERS ##############
 QVariant CaptoGloveAPI::getDevices(){
 
-    return QVariant::fromValue(m_devices);
+    return m_deviceListing.snapshot()->list;
 }
 
 QVariant CaptoGloveAPI::getServices(){
 
-    return QVariant::fromValue(m_services);
+    return m_serviceListing.snapshot()->list;
 }
 
 QVariant CaptoGloveAPI::getCharacteristics(){
 
-    return QVariant::fromValue(m_characteristics);
+    return m_characteristicListing.snapshot()->list;
 }
 
+ListingSnapshotPtr CaptoGloveAPI::deviceListing() const
+{
+    return m_deviceListing.snapshot();
+}
+
+ListingSnapshotPtr CaptoGloveAPI::serviceListing() const
+{
+    return m_serviceListing.snapshot();
+}
+
+ListingSnapshotPtr CaptoGloveAPI::characteristicListing() const
+{
+    return m_characteristicListing.snapshot();
+}
+
+// Getters below read m_latestState, safe from any thread
 int CaptoGloveAPI::getBatteryLevel()
 {
 
-    return m_batteryLevelValue;
+    return m_latestState.read().battery;
 
 }
 
 QByteArray CaptoGloveAPI::getCurrentFingerPosition()
 {
-    return m_currentFingerPosition;
+    const GloveState latest = m_latestState.read();
+    return QByteArray(reinterpret_cast<const char *>(latest.payload), latest.payloadSize);
+}
+
+FingerFrame CaptoGloveAPI::getCurrentFrame() const
+{
+    return m_latestState.read().frame;
+}
+
+QString CaptoGloveAPI::getPayloadFormat() const
+{
+    return QString(m_payloadFormat->name);
+}
+
+HandPose CaptoGloveAPI::getCurrentPose() const
+{
+    return m_latestState.read().pose;
+}
+
+captoglove_v1::DeviceInformationMsg CaptoGloveAPI::getDeviceInformation() const
+{
+    return m_deviceInformationMsg;
+}
+
+GloveState CaptoGloveAPI::getLatestState() const
+{
+    return m_latestState.read();
+}
+
+bool CaptoGloveAPI::loadCalibrationProfile(const QString &path)
+{
+    CalibrationProfile profile;
+    if (!profile.load(path)) {
+        LOG_WARNING("Can't load calibration profile %1", path);
+        return false;
+    }
+
+    m_handModel.setCalibration(profile);
+    if (m_autoCalibration)
+        m_autoCalibrator.seed(profile);
+    LOG_INFO("Loaded calibration of %1 for %2", profile.user, profile.glove);
+    return true;
+}
+
+bool CaptoGloveAPI::saveCalibrationProfile(const QString &path) const
+{
+    return m_handModel.calibration().save(path);
+}
+
+SequenceTracker::Stats CaptoGloveAPI::getStreamStats() const
+{
+    return m_sequenceTracker.stats();
+}
+
+double CaptoGloveAPI::getConnectionInterval() const
+{
+    return m_connectionIntervalMs;
+}
+
+FrameSubscriber::Counters CaptoGloveAPI::getPublishCounters() const
+{
+    return m_fingerStatePublisher.counters();
+}
+
+bool CaptoGloveAPI::saveTrace(const QString &path) const
+{
+    return ConnectionTrace::instance()->save(path);
+}
+
+bool CaptoGloveAPI::writeCommand(const QBluetoothUuid &characteristic, const QByteArray &value, bool idempotent)
+{
+    if (!m_fingerCommands.enqueue(characteristic, value, idempotent)) {
+        LOG_WARNING("Command queue full, dropping write to %1", characteristic.toString());
+        return false;
+    }
+
+    return true;
+}
+
+WriteQueue::Stats CaptoGloveAPI::getWriteStats() const
+{
+    return m_fingerCommands.stats();
+}
+
+MetricsRegistry *CaptoGloveAPI::metrics()
+{
+    return &m_metrics;
+}
+
+PublishPolicy CaptoGloveAPI::subscriberPolicy() const
+{
+    return m_subscriberPolicy;
+}
+
+FrameSubscriber *CaptoGloveAPI::addSubscriber(const PublishPolicy &policy, QThread *deliveryThread)
+{
+    auto subscriber = new FrameSubscriber(policy, this);
+    subscriber->setDeliveryThread(deliveryThread);
+    subscriber->setDropCounter(m_subscriberDropped);
+    connect(this, &CaptoGloveAPI::frameReceived, subscriber, &FrameSubscriber::offer);
+    return subscriber;
+}
+
+void CaptoGloveAPI::removeSubscriber(FrameSubscriber *subscriber)
+{
+    if (!subscriber || subscriber->parent() != this)
+        return;
+
+    disconnect(this, nullptr, subscriber, nullptr);
+    subscriber->deleteLater();
 }
 
 QString CaptoGloveAPI::getDeviceName()
 {
-    return m_deviceName;
+    return QString::fromUtf8(m_latestState.read().deviceName);
+}
+
+void CaptoGloveAPI::setCalibrationUser(const QString &user)
+{
+    if (user.isEmpty() || user == m_calibrationUser)
+        return;
+
+    saveCalibration();
+    const QString glove = m_calibrationGlove;
+    m_calibrationUser = user;
+    m_calibrationGlove.clear();
+    startCalibration(glove);
+}
+
+QString CaptoGloveAPI::getActiveGlove() const
+{
+    return m_onStandby ? m_standby.name() : m_deviceName;
+}
+
+void CaptoGloveAPI::setWantedDevice(const QString &name)
+{
+    m_wantedDevice = name;
 }
 
 bool CaptoGloveAPI::isRandomAddress() const
@@ -966,8 +1980,6 @@ bool CaptoGloveAPI::state()
 
 bool CaptoGloveAPI::alive() const
 {
-    if (m_batteryLevelService)
-        return m_batteryLevelService->state() == QLowEnergyService::ServiceDiscovered;
-
-    return false;
+    // Connected is not enough, the finger stream has to be flowing
+    return m_watchdog.isStreaming();
 }
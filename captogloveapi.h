@@ -14,6 +14,28 @@
 #include "deviceinfo.h"
 #include "serviceinfo.h"
 #include "characteristicinfo.h"
+#include "characteristicregistry.h"
+#include "listingsnapshot.h"
+#include "fingerframe.h"
+#include "sequencetracker.h"
+#include "framesubscriber.h"
+#include "glovestate.h"
+#include "payloadlayout.h"
+#include "handmodel.h"
+#include "autocalibrator.h"
+#include "orientationfilter.h"
+#include "logger.h"
+#include "metricsregistry.h"
+#include "subscriptionmanager.h"
+#include "deviceinforeader.h"
+#include "serviceprofile.h"
+#include "writequeue.h"
+#include "streamwatchdog.h"
+#include "standbylink.h"
+#include "connectiontrace.h"
+#include "sessionrecording.h"
+#include "frameexporter.h"
+#include "captogloveuuids.h"
 
 // Specific datatypes include
 #include <QDebug>
@@ -21,6 +43,11 @@
 #include <QTimer>
 #include <QtEndian>
 #include <QThread>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
 
 // Include protobuffer msg?
 #include <proto_impl/captoglove_v1.pb.h>
@@ -43,10 +70,49 @@ public:
     QVariant getServices();                                                                 // xx
     QVariant getCharacteristics();                                                          // xx
 
+    // Immutable versions of the listings above with the changes against the version before, any thread
+    ListingSnapshotPtr deviceListing() const;
+    ListingSnapshotPtr serviceListing() const;
+    ListingSnapshotPtr characteristicListing() const;
+
     // Service Getters
     int getBatteryLevel();                                                                  // xx
     QString getDeviceName();                                                                // xx
     QByteArray getCurrentFingerPosition();                                                  // xx
+    FingerFrame getCurrentFrame() const;
+    SequenceTracker::Stats getStreamStats() const;
+    double getConnectionInterval() const;
+    QString getPayloadFormat() const;
+    // Device Information and Generic Access values, complete once the last read of a connection is in
+    captoglove_v1::DeviceInformationMsg getDeviceInformation() const;
+    QString getActiveGlove() const;                                                         // delivering glove, the standby after a failover
+    HandPose getCurrentPose() const;
+    // Newest frame, pose, battery, RSSI and connection state as one record, any thread, never locks
+    GloveState getLatestState() const;
+
+    bool loadCalibrationProfile(const QString &path);
+    bool saveCalibrationProfile(const QString &path) const;
+    // Learned calibration is kept per glove and user, see [Calibration] in config.ini
+    void setCalibrationUser(const QString &user);
+    FrameSubscriber::Counters getPublishCounters() const;
+    MetricsRegistry *metrics();
+
+    // Ordered, rate limited writes to the finger service (f001 commands and configuration).
+    // idempotent writes only set a value, a newer one replaces it while it is still queued
+    bool writeCommand(const QBluetoothUuid &characteristic, const QByteArray &value, bool idempotent = false);
+    WriteQueue::Stats getWriteStats() const;
+
+    // Same path as a finger notification, for replay and the allocation check
+    void injectFingerPayload(const QByteArray &value);
+
+    // Startup and connection phases of all gloves as Chrome trace JSON, see [Trace] in config.ini
+    bool saveTrace(const QString &path) const;
+
+    // Filtered frame delivery, owned by the API. frameReady is emitted on deliveryThread,
+    // pass the receiver's thread so its backpressure policy bounds what waits for it
+    PublishPolicy subscriberPolicy() const;         // [Publish] in config.ini
+    FrameSubscriber *addSubscriber(const PublishPolicy &policy, QThread *deliveryThread = nullptr);
+    void removeSubscriber(FrameSubscriber *subscriber);
 
     QString getUpdate();                                                                    // xx
     bool alive() const;
@@ -57,6 +123,7 @@ public:
     void saveSettings       (QString path);                                                 // init, TODO
     void loadSettings       (QString path);                                                 // init, TODO
 
+    void setWantedDevice(const QString &name);                                              // matched against discovered names
     void initializeController (const QBluetoothDeviceInfo &info);                           // xx, TODO: Initialize controller
 
                                                                                             // init, TEST method
@@ -83,6 +150,7 @@ private slots:
     void deviceConnected();                                                                 // xx
     void deviceDisconnected();                                                              // xx
     void errorReceived();                                                                   // xx
+    void connectionUpdated(const QLowEnergyConnectionParameters &params);
     void serviceScanDone();                                                                 // xx
 
     // QLowEnergyService related
@@ -92,6 +160,10 @@ private slots:
     void setFingerMsg();
     void setBatteryMsg();
 
+    // ConnectionTrace
+    void detailsTraceStateChanged(QLowEnergyService::ServiceState state);
+    void saveTraceFile();
+
 
 Q_SIGNALS:
     void devicesUpdated();
@@ -106,11 +178,29 @@ Q_SIGNALS:
     void testSignal();
     void updateFingerState();
     void updateBatteryState();
+    void frameReceived(const FingerFrame &frame);
+    void poseUpdated(const HandPose &pose);
+    void gapDetected(quint64 firstSequence, int count);
+    void failedOver(const QString &from, const QString &to, const QString &reason);
 
 private:
     // QLowEnergyController
     void serviceDiscovered(const QBluetoothUuid &gatt);
     void checkServiceStatus(const QBluetoothUuid &uuid);
+    void releaseServices();
+    ServiceInfo *serviceInfo(const QBluetoothUuid &uuid) const;
+    // Service object of an advertised service, created on first use and owned by its ServiceInfo
+    QLowEnergyService *openService(const QBluetoothUuid &uuid);
+    void publishDevices();
+    void publishServices();
+    void publishCharacteristics();
+    void traceDetails(QLowEnergyService *service);
+    void traceFirstSample();
+    void startRecording();
+    void startCalibration(const QString &glove);
+    void publishConnection(GloveState::Connection connection);
+    void publishDeviceName(const QString &name);
+    void saveCalibration() const;
 
     void serviceStateChanged(QLowEnergyService::ServiceState s);
 
@@ -131,10 +221,32 @@ private:
 
     void genericAccessServiceStateChanged(QLowEnergyService::ServiceState s);
 
+    // Device information and generic access, read in one batch per connection
+    void setupDeviceInformation();
+    void deviceInformationRead(const DeviceInformation &information, bool cached);
+    void selectPayloadFormat();
+
+    // Notify characteristics streamed on every connection
+    void setupSubscriptions();
+
+    // Stall detection and recovery of the finger stream
+    void setupWatchdog();
+
+    // Hot standby glove taking over the output stream
+    void setupFailover();
+    bool failover(const QString &reason);
+
+    // Monitoring
+    void setupMetrics();
+    Histogram *connectTimeHistogram();
+    void collectMetrics();
+
     void fingerPoseServiceStateChanged(QLowEnergyService::ServiceState s);
 
     void fingerPoseCharacteristicChanged(const QLowEnergyCharacteristic &c,
                                          const QByteArray &value);
+    void fingerNotification(const QLowEnergyCharacteristic &c, const QByteArray &value);
+    void imuCharacteristicChanged(const QByteArray &value);
     void confirmedDescriptorWrite(const QLowEnergyDescriptor &d,
                                   const QByteArray &value);
 
@@ -150,6 +262,7 @@ private:
     void getScanParams();
 
     QString m_configPath;
+    QString m_wantedDevice = "CaptoGlove3148";
 
     QBluetoothDeviceDiscoveryAgent *m_discoveryAgent;
     QBluetoothLocalDevice *localDevice;
@@ -157,8 +270,35 @@ private:
     QLowEnergyController* m_controller = nullptr;
     QList<DeviceInfo *> m_devices;
     QList<QBluetoothDeviceInfo> m_devicesBTInfo;
-    QList<ServiceInfo *> m_services;
-    QMap<QBluetoothUuid, CharacteristicInfo*> m_characteristics;
+    QList<ServiceInfo *> m_services;                // every advertised service, objects opened lazily
+    QList<QBluetoothUuid> m_advertisedServices;
+    ServiceProfile m_profile = ServiceProfile::minimal();
+    QElapsedTimer m_connectTimer;
+
+    // Open ConnectionTrace spans of this glove, -1 when none
+    int m_traceTrack = -1;
+    int m_traceDiscovery = -1;
+    int m_traceConnect = -1;
+    int m_traceServices = -1;
+    int m_traceFirstSample = -1;
+    QHash<QLowEnergyService *, int> m_traceDetails;     // open discoverDetails span per service
+    QString m_traceFile;
+
+    // Raw finger notifications per connection, see [Recording] in config.ini
+    QString m_recordingDir;
+    SessionRecorder m_recorder;
+
+    // Decoded stream as Arrow file per connection, see [Export] in config.ini
+    QString m_arrowDir;
+    int m_arrowBatchRows = 16384;
+    FrameExporter m_arrowExport;
+    CharacteristicRegistry m_characteristics;
+
+    // Published listings, the *Updated signals only fire for a new version
+    ListingModel m_deviceListing;
+    ListingModel m_serviceListing;
+    ListingModel m_characteristicListing;
+    quint64 m_publishedCharacteristics = 0;
 
     int m_scanTimeout;
 
@@ -185,6 +325,18 @@ private:
 
     // Global characteristics
     QLowEnergyCharacteristic m_fingerPositionsChar;
+    SubscriptionManager m_subscriptions;
+    DeviceInfoReader m_deviceInfoReader;
+    StreamWatchdog m_watchdog;
+
+    // Hot standby, see [Failover] in config.ini. After a failover the spare delivers
+    // and this controller's glove is the standby until the next one
+    QString m_standbyDevice;
+    StandbyLink m_standby;
+    bool m_onStandby = false;
+    qint64 m_primaryLastUs = 0;             // last sample of this glove while it is the standby
+    qint64 m_failoverUs = 0;                // switch pending until the first sample of the new source
+    WriteQueue m_fingerCommands;
 
     // Characteristics
     QLowEnergyDescriptor m_batteryNotificationDesc;
@@ -195,9 +347,82 @@ private:
     DeviceInfo m_peripheralDevice;
 
     // Values of interest for getter
-    int m_batteryLevelValue;
+    int m_batteryLevelValue = -1;
     QByteArray m_currentFingerPosition;
+    FingerFrame m_currentFrame;
     QString m_deviceName;
+    QString m_modelNumber;
+    QString m_firmwareRevision;
+
+    // Payload decoding, picked per glove model at connect
+    const PayloadFormat *m_payloadFormat = &PayloadFormats::defaultFormat();
+    QString m_defaultPayloadFormat;
+    QMap<QString, QString> m_payloadFormatByModel;
+    Counter *m_decodeErrors = nullptr;
+
+    // Sample stream
+    static const int MaxGapFill = 16;
+    QElapsedTimer m_streamClock;
+    SequenceTracker m_sequenceTracker;
+    FingerFrame m_gapFill[MaxGapFill];
+    double m_connectionIntervalMs = 0.0;
+
+    // Inertial data, fused into an orientation attached to every frame
+    static const int MaxImuSamples = 8;
+    QBluetoothUuid m_imuCharacteristic;
+    float m_accelScale = 1.0f / 16384.0f;
+    float m_gyroScale = 1.0f;
+    OrientationFilter m_orientationFilter;
+    ImuSample m_imuSamples[MaxImuSamples];
+    qint64 m_lastImuUs = 0;
+    bool m_hasOrientation = false;
+
+    // Joint angles, computed once per frame for all consumers
+    HandModel m_handModel;
+    HandPose m_currentPose;
+
+    // Latest values for readers on other threads, the getters read it too
+    GloveStateBlock m_latestState;
+
+    // Online calibration of the ranges m_handModel normalizes with, see [Calibration] in config.ini
+    AutoCalibrator m_autoCalibrator;
+    bool m_autoCalibration = true;
+    QString m_calibrationUser = "default";
+    QString m_calibrationDir;
+    QString m_calibrationGlove;             // glove whose ranges are being learned
+    QTimer m_calibrationSaveTimer;
+
+    // Drives updateFingerState, see [Publish] in config.ini
+    FrameSubscriber m_fingerStatePublisher;
+    PublishPolicy m_subscriberPolicy;
+
+    // Monitoring, see [Metrics] in config.ini. Hot path only touches the atomics below
+    MetricsRegistry m_metrics;
+    Counter *m_fingerNotifications = nullptr;
+    Counter *m_imuNotifications = nullptr;
+    Counter *m_batteryNotifications = nullptr;
+    Counter *m_droppedFrames = nullptr;
+    Counter *m_duplicateFrames = nullptr;
+    Counter *m_reconnects = nullptr;
+    Counter *m_stalls = nullptr;
+    Counter *m_failovers = nullptr;
+    Counter *m_subscriberDropped = nullptr;
+    Gauge *m_connectionIntervalGauge = nullptr;
+    Gauge *m_connectTimeGauge = nullptr;
+    QHash<QString, Histogram *> m_connectTimes;     // per service profile, see connectTimeHistogram
+    Gauge *m_rssiGauge = nullptr;
+    Gauge *m_batteryGauge = nullptr;
+    Gauge *m_publishQueueGauge = nullptr;
+    Gauge *m_subscriberQueueGauge = nullptr;
+    Gauge *m_writeQueueGauge = nullptr;
+    Gauge *m_logDroppedGauge = nullptr;
+    Histogram *m_notificationInterval = nullptr;
+    Histogram *m_writeLatency = nullptr;
+    Histogram *m_stallDetect = nullptr;
+    Histogram *m_stallRecover = nullptr;
+    Histogram *m_failoverSwitch = nullptr;
+    Histogram *m_failoverGap = nullptr;
+    qint64 m_lastFingerUs = 0;
 
     captoglove_v1::BatteryLevelMsg m_batteryMsg;
     captoglove_v1::DeviceInformationMsg m_deviceInformationMsg;
@@ -0,0 +1,44 @@
+#ifndef CAPTOGLOVEUUIDS_H
+#define CAPTOGLOVEUUIDS_H
+
+#include "qbluetoothuuid.h"
+
+// Vendor specific GATT uuids of the CaptoGlove. Built once, compared often.
+namespace CaptoGloveUuids
+{
+
+inline const QBluetoothUuid &fingerPositionService()
+{
+    static const QBluetoothUuid uuid(QStringLiteral("0000ff05-3333-acda-0000-ff522ee73921"));
+    return uuid;
+}
+
+// Command characteristic, f.e. "83" requests finger positions
+inline const QBluetoothUuid &fingerCommand()
+{
+    static const QBluetoothUuid uuid(QStringLiteral("0000f001-3333-acda-0000-ff522ee73921"));
+    return uuid;
+}
+
+inline const QBluetoothUuid &fingerF002()
+{
+    static const QBluetoothUuid uuid(QStringLiteral("0000f002-3333-acda-0000-ff522ee73921"));
+    return uuid;
+}
+
+// Notifies finger positions
+inline const QBluetoothUuid &fingerPositions()
+{
+    static const QBluetoothUuid uuid(QStringLiteral("0000f003-3333-acda-0000-ff522ee73921"));
+    return uuid;
+}
+
+inline const QBluetoothUuid &fingerF004()
+{
+    static const QBluetoothUuid uuid(QStringLiteral("0000f004-3333-acda-0000-ff522ee73921"));
+    return uuid;
+}
+
+}
+
+#endif // CAPTOGLOVEUUIDS_H
@@ -38,7 +38,11 @@ QString CharacteristicInfo::getName() const
 
 QString CharacteristicInfo::getUuid() const
 {
-    const QBluetoothUuid uuid = m_characteristic.uuid();
+    return uuidToString(m_characteristic.uuid());
+}
+
+QString CharacteristicInfo::uuidToString(const QBluetoothUuid &uuid)
+{
     bool success = false;
     quint16 result16 = uuid.toUInt16(&success);
     if (success)
@@ -52,18 +56,22 @@ QString CharacteristicInfo::getUuid() const
 }
 
 QString CharacteristicInfo::getValue() const
+{
+    return valueToString(m_characteristic.value());
+}
+
+QString CharacteristicInfo::valueToString(const QByteArray &value)
 {
     // Show raw string first and hex value below
-    QByteArray a = m_characteristic.value();
     QString result;
-    if (a.isEmpty()) {
+    if (value.isEmpty()) {
         result = QStringLiteral("<none>");
         return result;
     }
 
-    result = a;
+    result = value;
     result += QLatin1Char('\n');
-    result += a.toHex();
+    result += value.toHex();
 
     return result;
 }
@@ -74,9 +82,13 @@ QString CharacteristicInfo::getHandle() const
 }
 
 QString CharacteristicInfo::getPermission() const
+{
+    return propertiesToString(m_characteristic.properties());
+}
+
+QString CharacteristicInfo::propertiesToString(QLowEnergyCharacteristic::PropertyTypes permission)
 {
     QString properties = "( ";
-    uint permission = m_characteristic.properties();
     if (permission & QLowEnergyCharacteristic::Read)
         properties += QStringLiteral(" Read");
     if (permission & QLowEnergyCharacteristic::Write)
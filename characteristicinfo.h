@@ -24,6 +24,11 @@ public:
     QString getPermission() const;
     QLowEnergyCharacteristic getCharacteristic() const;
 
+    // Display formats, shared with the listing snapshots
+    static QString uuidToString(const QBluetoothUuid &uuid);
+    static QString valueToString(const QByteArray &value);
+    static QString propertiesToString(QLowEnergyCharacteristic::PropertyTypes permission);
+
 Q_SIGNALS:
     void characteristicChanged();
 
@@ -0,0 +1,90 @@
+#include "characteristicregistry.h"
+
+void CharacteristicRegistry::add(const QBluetoothUuid &service, const QLowEnergyCharacteristic &characteristic)
+{
+    CharacteristicRecord record;
+    record.handle = characteristic.handle();
+    record.service = service;
+    record.uuid = characteristic.uuid();
+    record.properties = characteristic.properties();
+    record.name = characteristic.name();
+    record.value = characteristic.value();
+    add(record);
+}
+
+void CharacteristicRegistry::add(const CharacteristicRecord &record)
+{
+    for (CharacteristicRecord &r : m_records) {
+        if (r.handle == record.handle) {
+            r = record;
+            m_revision++;
+            return;
+        }
+    }
+
+    m_records.append(record);
+    m_revision++;
+}
+
+bool CharacteristicRegistry::setValue(QLowEnergyHandle handle, const QByteArray &value)
+{
+    for (CharacteristicRecord &r : m_records) {
+        if (r.handle != handle)
+            continue;
+        if (r.value == value)
+            return false;
+
+        r.value = value;
+        m_revision++;
+        return true;
+    }
+
+    return false;
+}
+
+void CharacteristicRegistry::recycle()
+{
+    // resize keeps the capacity, a reconnect fills the same storage again
+    m_records.resize(0);
+    m_revision++;
+}
+
+const CharacteristicRecord *CharacteristicRegistry::find(QLowEnergyHandle handle) const
+{
+    for (const CharacteristicRecord &r : m_records) {
+        if (r.handle == handle)
+            return &r;
+    }
+
+    return nullptr;
+}
+
+const CharacteristicRecord *CharacteristicRegistry::find(const QBluetoothUuid &service, const QBluetoothUuid &uuid) const
+{
+    for (const CharacteristicRecord &r : m_records) {
+        if (r.service == service && r.uuid == uuid)
+            return &r;
+    }
+
+    return nullptr;
+}
+
+QVector<CharacteristicRecord> CharacteristicRegistry::records() const
+{
+    return m_records;
+}
+
+int CharacteristicRegistry::size() const
+{
+    return m_records.size();
+}
+
+int CharacteristicRegistry::capacity() const
+{
+    return m_records.capacity();
+}
+
+quint64 CharacteristicRegistry::revision() const
+{
+    return m_revision;
+}
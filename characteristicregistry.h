@@ -0,0 +1,49 @@
+#ifndef CHARACTERISTICREGISTRY_H
+#define CHARACTERISTICREGISTRY_H
+
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+
+#include <QtBluetooth/QBluetoothUuid>
+#include <QtBluetooth/QLowEnergyCharacteristic>
+
+// Plain copy of what is worth keeping about a discovered characteristic
+struct CharacteristicRecord
+{
+    QLowEnergyHandle handle = 0;
+    QBluetoothUuid service;
+    QBluetoothUuid uuid;
+    QLowEnergyCharacteristic::PropertyTypes properties;
+    QString name;
+    QByteArray value;                   // last read or notified value, empty if never read
+};
+
+Q_DECLARE_METATYPE(CharacteristicRecord)
+
+// Characteristics of the current connection keyed by attribute handle. Adding
+// a handle again updates its record in place, recycle() empties the registry
+// for the next connection but keeps its storage.
+class CharacteristicRegistry
+{
+public:
+    void add(const QBluetoothUuid &service, const QLowEnergyCharacteristic &characteristic);
+    void add(const CharacteristicRecord &record);
+    // False if the handle is unknown or already has value
+    bool setValue(QLowEnergyHandle handle, const QByteArray &value);
+    void recycle();
+
+    const CharacteristicRecord *find(QLowEnergyHandle handle) const;
+    const CharacteristicRecord *find(const QBluetoothUuid &service, const QBluetoothUuid &uuid) const;
+    QVector<CharacteristicRecord> records() const;
+    int size() const;
+    int capacity() const;
+    // Bumped by every add() and recycle(), tells listings when to rebuild
+    quint64 revision() const;
+
+private:
+    QVector<CharacteristicRecord> m_records;
+    quint64 m_revision = 0;
+};
+
+#endif // CHARACTERISTICREGISTRY_H
@@ -0,0 +1,180 @@
+#include "connectiontrace.h"
+#include "logger.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+namespace {
+const char Category[] = "captoglove";
+}
+
+ConnectionTrace *ConnectionTrace::instance()
+{
+    static ConnectionTrace trace;
+    return &trace;
+}
+
+ConnectionTrace::ConnectionTrace()
+{
+    m_clock.start();
+}
+
+void ConnectionTrace::setEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_enabled = enabled;
+}
+
+bool ConnectionTrace::isEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_enabled;
+}
+
+int ConnectionTrace::addTrack(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    m_tracks.append(name);
+    return m_tracks.size() - 1;
+}
+
+void ConnectionTrace::setTrackName(int track, const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    if (track >= 0 && track < m_tracks.size())
+        m_tracks[track] = name;
+}
+
+int ConnectionTrace::begin(int track, const char *name, const QString &detail)
+{
+    return record(track, name, detail, false);
+}
+
+void ConnectionTrace::end(int span)
+{
+    if (span < 0)
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    // Spans end soon after they begin, search from the newest
+    for (int i = m_events.size() - 1; i >= 0; --i) {
+        Event &event = m_events[i];
+        if (event.id != span)
+            continue;
+        if (event.endUs < 0)
+            event.endUs = now();
+        return;
+    }
+}
+
+void ConnectionTrace::instant(int track, const char *name, const QString &detail)
+{
+    record(track, name, detail, true);
+}
+
+void ConnectionTrace::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_events.clear();
+    m_dropped = 0;
+}
+
+QByteArray ConnectionTrace::toJson() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    // Every glove is shown as a process, its spans as async slices
+    QJsonArray events;
+    for (int track = 0; track < m_tracks.size(); ++track) {
+        QJsonObject args;
+        args["name"] = m_tracks.at(track);
+        QJsonObject meta;
+        meta["name"] = "process_name";
+        meta["ph"] = "M";
+        meta["pid"] = track + 1;
+        meta["args"] = args;
+        events.append(meta);
+    }
+
+    for (const Event &event : m_events) {
+        QJsonObject json;
+        json["name"] = QString::fromLatin1(event.name);
+        json["cat"] = QString::fromLatin1(Category);
+        json["pid"] = event.track + 1;
+        json["tid"] = event.track + 1;
+        json["ts"] = event.startUs;
+        if (!event.detail.isEmpty()) {
+            QJsonObject args;
+            args["detail"] = event.detail;
+            json["args"] = args;
+        }
+
+        if (event.instant) {
+            json["ph"] = "i";
+            json["s"] = "p";
+            events.append(json);
+            continue;
+        }
+
+        // Open spans get no end, the viewer marks them as unfinished
+        json["ph"] = "b";
+        json["id"] = event.id;
+        events.append(json);
+        if (event.endUs >= 0) {
+            QJsonObject endJson = json;
+            endJson["ph"] = "e";
+            endJson["ts"] = event.endUs;
+            events.append(endJson);
+        }
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+    if (m_dropped > 0)
+        root["droppedEvents"] = static_cast<qint64>(m_dropped);
+
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool ConnectionTrace::save(const QString &path) const
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(toJson()) < 0 || !file.commit()) {
+        LOG_WARNING("Can't write connection trace to %1", path);
+        return false;
+    }
+
+    return true;
+}
+
+int ConnectionTrace::record(int track, const char *name, const QString &detail, bool instant)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_enabled || track < 0)
+        return -1;
+
+    if (m_events.size() >= MaxEvents) {
+        m_dropped++;
+        return -1;
+    }
+
+    Event event;
+    event.id = m_nextId++;
+    event.track = track;
+    event.name = name;
+    event.detail = detail;
+    event.startUs = now();
+    event.endUs = instant ? event.startUs : -1;
+    event.instant = instant;
+    m_events.append(event);
+
+    return event.id;
+}
+
+qint64 ConnectionTrace::now() const
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
@@ -0,0 +1,61 @@
+#ifndef CONNECTIONTRACE_H
+#define CONNECTIONTRACE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QElapsedTimer>
+
+// Process wide recorder of startup and connection phases, one track per glove.
+// Exported as Chrome trace event JSON, open it in Perfetto or chrome://tracing.
+// Only meant for cold paths, every call takes a mutex.
+class ConnectionTrace
+{
+public:
+    static const int MaxEvents = 20000;
+
+    static ConnectionTrace *instance();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    int addTrack(const QString &name);
+    void setTrackName(int track, const QString &name);
+
+    // Returns the span to pass to end(), -1 while disabled
+    int begin(int track, const char *name, const QString &detail = QString());
+    void end(int span);
+    void instant(int track, const char *name, const QString &detail = QString());
+
+    void clear();
+    QByteArray toJson() const;
+    bool save(const QString &path) const;
+
+private:
+    ConnectionTrace();
+    Q_DISABLE_COPY(ConnectionTrace)
+
+    struct Event {
+        int id;
+        int track;
+        const char *name;
+        QString detail;
+        qint64 startUs;
+        qint64 endUs;           // -1 while the span is open
+        bool instant;
+    };
+
+    int record(int track, const char *name, const QString &detail, bool instant);
+    qint64 now() const;
+
+    mutable QMutex m_mutex;
+    QElapsedTimer m_clock;
+    bool m_enabled = false;
+    QList<QString> m_tracks;
+    QList<Event> m_events;
+    int m_nextId = 0;
+    quint64 m_dropped = 0;
+};
+
+#endif // CONNECTIONTRACE_H
@@ -1,4 +1,5 @@
 #include "deviceinfo.h"
+#include "logger.h"
 #include "qbluetoothuuid.h"
 
 
@@ -29,7 +30,7 @@ QBluetoothDeviceInfo DeviceInfo::getDevice()
 
 void DeviceInfo::setDevice(const QBluetoothDeviceInfo &dev)
 {
-    qDebug() << "Setting device!";
+    LOG_DEBUG("Setting device!");
     device = QBluetoothDeviceInfo(dev);
     Q_EMIT deviceChanged();
 }
@@ -0,0 +1,190 @@
+#include "deviceinforeader.h"
+#include "logger.h"
+#include "connectiontrace.h"
+
+QString DeviceInformation::text(QBluetoothUuid::CharacteristicType type) const
+{
+    return QString::fromUtf8(values.value(QBluetoothUuid(type))).trimmed();
+}
+
+DeviceInfoReader::DeviceInfoReader(QObject *parent):
+    QObject(parent)
+{
+}
+
+void DeviceInfoReader::start(const QString &address, const QList<QBluetoothUuid> &services)
+{
+    reset();
+
+    m_address = address;
+    m_waiting = services;
+    m_current = DeviceInformation();
+
+    // Cached values can only be trusted once the firmware revision confirms them
+    const bool cached = m_cache.contains(address) && services.contains(QBluetoothUuid(QBluetoothUuid::DeviceInformation));
+    m_mode = cached ? Verifying : Reading;
+    m_traceSpan = ConnectionTrace::instance()->begin(m_traceTrack, "readDeviceInformation",
+                                                     cached ? QStringLiteral("cached") : QString());
+    checkDone();
+}
+
+void DeviceInfoReader::attach(QLowEnergyService *service)
+{
+    if (!service || !m_waiting.contains(service->serviceUuid()))
+        return;
+
+    m_services.append(service);
+    connect(service, &QLowEnergyService::stateChanged, this, &DeviceInfoReader::serviceStateChanged, Qt::UniqueConnection);
+    connect(service, &QLowEnergyService::characteristicRead, this, &DeviceInfoReader::characteristicRead, Qt::UniqueConnection);
+    connect(service, QOverload<QLowEnergyService::ServiceError>::of(&QLowEnergyService::error),
+            this, &DeviceInfoReader::serviceError, Qt::UniqueConnection);
+
+    if (service->state() == QLowEnergyService::ServiceDiscovered)
+        serviceDiscovered(service);
+}
+
+void DeviceInfoReader::reset()
+{
+    if (m_mode == Verifying || m_mode == Reading)
+        ConnectionTrace::instance()->end(m_traceSpan);
+
+    m_mode = Idle;
+    m_waiting.clear();
+    m_services.clear();
+    m_pending = 0;
+    m_traceSpan = -1;
+}
+
+bool DeviceInfoReader::needs(const QBluetoothUuid &service) const
+{
+    return m_mode != Verifying || service != QBluetoothUuid(QBluetoothUuid::GenericAccess);
+}
+
+void DeviceInfoReader::setTraceTrack(int track)
+{
+    m_traceTrack = track;
+}
+
+void DeviceInfoReader::serviceStateChanged(QLowEnergyService::ServiceState state)
+{
+    QLowEnergyService *service = qobject_cast<QLowEnergyService *>(sender());
+    if (!service)
+        return;
+
+    if (state == QLowEnergyService::ServiceDiscovered) {
+        serviceDiscovered(service);
+    } else if (state == QLowEnergyService::InvalidService) {
+        m_waiting.removeAll(service->serviceUuid());
+        checkDone();
+    }
+}
+
+void DeviceInfoReader::serviceDiscovered(QLowEnergyService *service)
+{
+    if (m_mode == Reading) {
+        readAll(service);
+        return;
+    }
+    if (m_mode != Verifying || service->serviceUuid() != QBluetoothUuid(QBluetoothUuid::DeviceInformation))
+        return;
+
+    const QLowEnergyCharacteristic firmware = service->characteristic(QBluetoothUuid::FirmwareRevisionString);
+    if (!firmware.isValid() || !(firmware.properties() & QLowEnergyCharacteristic::Read)) {
+        refresh();
+        return;
+    }
+
+    m_pending++;
+    service->readCharacteristic(firmware);
+}
+
+void DeviceInfoReader::readAll(QLowEnergyService *service)
+{
+    if (!m_waiting.removeAll(service->serviceUuid()))
+        return;
+
+    // No waiting between the reads, the controller queues them
+    const QList<QLowEnergyCharacteristic> characteristics = service->characteristics();
+    for (const QLowEnergyCharacteristic &c : characteristics) {
+        if (!(c.properties() & QLowEnergyCharacteristic::Read))
+            continue;
+        m_pending++;
+        service->readCharacteristic(c);
+    }
+
+    checkDone();
+}
+
+void DeviceInfoReader::refresh()
+{
+    LOG_INFO("Reading device information of %1", m_address);
+    m_mode = Reading;
+    m_pending = 0;
+    m_current = DeviceInformation();
+
+    for (const QPointer<QLowEnergyService> &service : qAsConst(m_services)) {
+        if (service && service->state() == QLowEnergyService::ServiceDiscovered)
+            readAll(service);
+    }
+
+    emit refreshNeeded();
+    checkDone();
+}
+
+void DeviceInfoReader::characteristicRead(const QLowEnergyCharacteristic &characteristic, const QByteArray &value)
+{
+    if (m_pending == 0)
+        return;
+    m_pending--;
+
+    if (m_mode == Verifying) {
+        const DeviceInformation &cached = m_cache[m_address];
+        if (value == cached.values.value(characteristic.uuid())) {
+            m_current = cached;
+            finish(true);
+            return;
+        }
+
+        LOG_INFO("Firmware of %1 changed from %2 to %3", m_address,
+                 cached.text(QBluetoothUuid::FirmwareRevisionString), QString::fromUtf8(value).trimmed());
+        refresh();
+        return;
+    }
+
+    if (m_mode == Reading) {
+        m_current.values.insert(characteristic.uuid(), value);
+        checkDone();
+    }
+}
+
+void DeviceInfoReader::serviceError(QLowEnergyService::ServiceError error)
+{
+    if (error != QLowEnergyService::CharacteristicReadError || m_pending == 0)
+        return;
+
+    // The error doesn't say which read failed, that value is just left out
+    m_pending--;
+    LOG_WARNING("Reading device information of %1 failed for one characteristic", m_address);
+    if (m_mode == Verifying)
+        refresh();
+    else
+        checkDone();
+}
+
+void DeviceInfoReader::finish(bool cached)
+{
+    m_mode = Done;
+    m_waiting.clear();
+    ConnectionTrace::instance()->end(m_traceSpan);
+    m_traceSpan = -1;
+
+    if (!cached && !m_current.values.isEmpty())
+        m_cache.insert(m_address, m_current);
+    emit finished(m_current, cached);
+}
+
+void DeviceInfoReader::checkDone()
+{
+    if (m_mode == Reading && m_pending == 0 && m_waiting.isEmpty())
+        finish(false);
+}
@@ -0,0 +1,82 @@
+#ifndef DEVICEINFOREADER_H
+#define DEVICEINFOREADER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QPointer>
+
+#include <QtBluetooth/QLowEnergyService>
+#include <QtBluetooth/QBluetoothUuid>
+
+// Values of every readable Device Information and Generic Access
+// characteristic of one glove
+struct DeviceInformation
+{
+    QMap<QBluetoothUuid, QByteArray> values;
+
+    // UTF-8 string characteristic, trimmed, empty if the glove doesn't have it
+    QString text(QBluetoothUuid::CharacteristicType type) const;
+};
+
+// Reads the static information of a glove once per connection. All reads of
+// a service are queued back to back as soon as its details are discovered and
+// finished() fires when the last reply is in. The result is cached per glove
+// address: on a reconnect only the firmware revision is read, and if it is
+// unchanged the cached values are used and Generic Access isn't discovered.
+class DeviceInfoReader : public QObject
+{
+    Q_OBJECT
+public:
+    DeviceInfoReader(QObject *parent = nullptr);
+
+    // New connection to the glove at address, services are the ones to read
+    void start(const QString &address, const QList<QBluetoothUuid> &services);
+    // Hooks a freshly created service object, reads it once discovered
+    void attach(QLowEnergyService *service);
+    // Connection lost, the cache is kept
+    void reset();
+
+    // False for services the cached values may still stand in for
+    bool needs(const QBluetoothUuid &service) const;
+
+    // Reads show up on this ConnectionTrace track
+    void setTraceTrack(int track);
+
+Q_SIGNALS:
+    void finished(const DeviceInformation &information, bool cached);
+    // Firmware changed, services needs() turned down have to be discovered after all
+    void refreshNeeded();
+
+private slots:
+    void serviceStateChanged(QLowEnergyService::ServiceState state);
+    void characteristicRead(const QLowEnergyCharacteristic &characteristic, const QByteArray &value);
+    void serviceError(QLowEnergyService::ServiceError error);
+
+private:
+    enum Mode {
+        Idle,
+        Verifying,      // firmware revision read, cached values pending on it
+        Reading,
+        Done
+    };
+
+    void serviceDiscovered(QLowEnergyService *service);
+    void readAll(QLowEnergyService *service);
+    void refresh();
+    void finish(bool cached);
+    void checkDone();
+
+    Mode m_mode = Idle;
+    QString m_address;
+    QList<QBluetoothUuid> m_waiting;        // services whose reads aren't queued yet
+    QList<QPointer<QLowEnergyService> > m_services;
+    int m_pending = 0;
+    DeviceInformation m_current;
+    QHash<QString, DeviceInformation> m_cache;
+    int m_traceTrack = -1;
+    int m_traceSpan = -1;
+};
+
+#endif // DEVICEINFOREADER_H
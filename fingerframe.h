@@ -0,0 +1,31 @@
+#ifndef FINGERFRAME_H
+#define FINGERFRAME_H
+
+#include <QtGlobal>
+#include <QMetaType>
+
+// One decoded sample of the finger position stream
+struct FingerFrame
+{
+    enum Flag {
+        NoFlags         = 0x00,
+        GapBefore       = 0x01,     // one or more samples were lost right before this one
+        Filled          = 0x02,     // synthesized by the gap fill policy, never received
+        Duplicate       = 0x04,     // same sample delivered more than once
+        HasOrientation  = 0x08,     // orientation holds the latest IMU fusion result
+        SourceChanged   = 0x10      // first sample from another glove after a failover
+    };
+
+    static const int MaxChannels = 10;
+
+    quint64 sequence = 0;
+    qint64 timestampUs = 0;
+    quint32 flags = NoFlags;
+    int channelCount = 0;
+    float channels[MaxChannels] = {};
+    float orientation[4] = { 1.0f, 0.0f, 0.0f, 0.0f };     // w, x, y, z
+};
+
+Q_DECLARE_METATYPE(FingerFrame)
+
+#endif // FINGERFRAME_H
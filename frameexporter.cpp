@@ -0,0 +1,117 @@
+#include "frameexporter.h"
+#include "sessionrecording.h"
+#include "sequencetracker.h"
+#include "payloadlayout.h"
+#include "logger.h"
+
+namespace {
+
+// Column names must outlive the writer
+const char *const ChannelNames[FingerFrame::MaxChannels] = {
+    "ch0", "ch1", "ch2", "ch3", "ch4", "ch5", "ch6", "ch7", "ch8", "ch9"
+};
+const char *const FlexionNames[HandPose::FingerCount] = {
+    "flexion_thumb", "flexion_index", "flexion_middle", "flexion_ring", "flexion_little"
+};
+const char *const OrientationNames[4] = { "qw", "qx", "qy", "qz" };
+
+const int ReadRecords = 4096;
+
+}
+
+FrameExporter::FrameExporter()
+{
+    for (int ch = 0; ch < FingerFrame::MaxChannels; ++ch)
+        m_channels[ch] = -1;
+}
+
+bool FrameExporter::open(const QString &path, int channels, int batchRows, ArrowWriter::Mode mode)
+{
+    close();
+    m_channelCount = qBound(0, channels, static_cast<int>(FingerFrame::MaxChannels));
+
+    m_writer.clearColumns();
+    m_timestamp = m_writer.addColumn("timestamp_us", ArrowWriter::Int64);
+    m_sequence = m_writer.addColumn("sequence", ArrowWriter::UInt64);
+    m_flags = m_writer.addColumn("flags", ArrowWriter::UInt32);
+    for (int ch = 0; ch < m_channelCount; ++ch)
+        m_channels[ch] = m_writer.addColumn(ChannelNames[ch], ArrowWriter::Float32);
+    for (int f = 0; f < HandPose::FingerCount; ++f)
+        m_flexion[f] = m_writer.addColumn(FlexionNames[f], ArrowWriter::Float32);
+    for (int k = 0; k < 4; ++k)
+        m_orientation[k] = m_writer.addColumn(OrientationNames[k], ArrowWriter::Float32);
+    m_battery = m_writer.addColumn("battery", ArrowWriter::Int8);
+
+    return m_writer.open(path, batchRows, mode);
+}
+
+bool FrameExporter::close()
+{
+    return m_writer.close();
+}
+
+void FrameExporter::append(const FingerFrame &frame, const HandPose &pose, int battery)
+{
+    m_writer.setInt(m_timestamp, frame.timestampUs);
+    m_writer.setInt(m_sequence, static_cast<qint64>(frame.sequence));
+    m_writer.setInt(m_flags, frame.flags);
+    for (int ch = 0; ch < m_channelCount; ++ch)
+        m_writer.setFloat(m_channels[ch], ch < frame.channelCount ? frame.channels[ch] : 0.0f);
+    for (int f = 0; f < HandPose::FingerCount; ++f)
+        m_writer.setFloat(m_flexion[f], pose.flexion[f]);
+    for (int k = 0; k < 4; ++k)
+        m_writer.setFloat(m_orientation[k], frame.orientation[k]);
+    m_writer.setInt(m_battery, battery);
+    m_writer.commitRow();
+}
+
+quint64 FrameExporter::rows() const
+{
+    return m_writer.rows();
+}
+
+bool FrameExporter::exportRecording(const QString &recordingPath, const QString &outputPath, const HandModel &model)
+{
+    SessionRecording recording;
+    if (!recording.open(recordingPath)) {
+        LOG_WARNING("%1 is not a recording", recordingPath);
+        return false;
+    }
+
+    const SessionHeader header = recording.header();
+    const PayloadFormat *format = PayloadFormats::find(header.format);
+    if (!format)
+        format = &PayloadFormats::defaultFormat();
+
+    FrameExporter exporter;
+    if (!exporter.open(outputPath, format->channels))
+        return false;
+
+    SequenceTracker tracker;
+    tracker.setCounter(header.counterOffset, header.counterWidth);
+
+    QByteArray buffer;
+    FingerFrame frame;
+    HandPose pose;
+    uchar scratch[SequenceTracker::MaxPayload];
+    for (qint64 first = 0; first < recording.recordCount(); first += ReadRecords) {
+        const int read = recording.read(first, ReadRecords, buffer);
+        for (int i = 0; i < read; ++i) {
+            const uchar *payload;
+            int size;
+            SessionRecording::record(buffer.constData() + i * header.recordSize, header.recordSize,
+                                     frame.timestampUs, payload, size);
+
+            frame.flags = FingerFrame::NoFlags;
+            int dataSize = size;
+            const uchar *channels = tracker.channelData(payload, dataSize, scratch);
+            if (!format->decode(channels, dataSize, frame) || tracker.track(payload, size, frame) < 0)
+                continue;
+
+            model.evaluate(frame, pose);
+            exporter.append(frame, pose, -1);
+        }
+    }
+
+    return exporter.close();
+}
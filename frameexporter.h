@@ -0,0 +1,43 @@
+#ifndef FRAMEEXPORTER_H
+#define FRAMEEXPORTER_H
+
+#include <QString>
+
+#include "arrowwriter.h"
+#include "fingerframe.h"
+#include "handmodel.h"
+
+// Decoded finger stream as an Arrow file with one column per value:
+// timestamp_us, sequence, flags, ch0..chN, flexion per finger, orientation
+// qw..qz and battery (-1 unknown). Fed live from the sample stream or
+// offline from a recording.
+class FrameExporter
+{
+public:
+    FrameExporter();
+
+    // Live streams use ArrowWriter::Background, so no batch is written on the sample path
+    bool open(const QString &path, int channels, int batchRows = 16384, ArrowWriter::Mode mode = ArrowWriter::Inline);
+    bool isOpen() const { return m_writer.isOpen(); }
+    bool close();
+
+    void append(const FingerFrame &frame, const HandPose &pose, int battery);
+    quint64 rows() const;
+
+    // Decodes a recording (see sessionrecording.h) like the live stream does, recordings hold no IMU or battery
+    static bool exportRecording(const QString &recordingPath, const QString &outputPath, const HandModel &model);
+
+private:
+    ArrowWriter m_writer;
+    int m_channelCount = 0;
+
+    int m_timestamp = -1;
+    int m_sequence = -1;
+    int m_flags = -1;
+    int m_channels[FingerFrame::MaxChannels];
+    int m_flexion[HandPose::FingerCount];
+    int m_orientation[4];
+    int m_battery = -1;
+};
+
+#endif // FRAMEEXPORTER_H
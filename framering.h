@@ -0,0 +1,62 @@
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+#include <atomic>
+
+#include "fingerframe.h"
+
+// Single producer / single consumer frame queue. push runs on the Qt thread,
+// pop on any one reader thread, neither allocates nor locks. When full the
+// newest frame is dropped, the reader always sees a contiguous run.
+class FrameRing
+{
+public:
+    static const int Capacity = 256;       // power of two
+
+    bool push(const FingerFrame &frame)
+    {
+        const quint32 head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) >= static_cast<quint32>(Capacity)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        m_frames[head & (Capacity - 1)] = frame;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    int pop(FingerFrame *out, int maxFrames)
+    {
+        return pop(out, maxFrames, [](FingerFrame &to, const FingerFrame &from) { to = from; });
+    }
+
+    // convert(out[i], frame) copies into a foreign layout without a temporary
+    template <typename T, typename Convert>
+    int pop(T *out, int maxFrames, Convert convert)
+    {
+        const quint32 tail = m_tail.load(std::memory_order_relaxed);
+        const quint32 available = m_head.load(std::memory_order_acquire) - tail;
+        const int count = qMin(static_cast<int>(available), maxFrames);
+        for (int i = 0; i < count; ++i)
+            convert(out[i], m_frames[(tail + i) & (Capacity - 1)]);
+
+        m_tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    int size() const
+    {
+        return static_cast<int>(m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire));
+    }
+
+    quint64 dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    FingerFrame m_frames[Capacity];
+    std::atomic<quint32> m_head{0};
+    std::atomic<quint32> m_tail{0};
+    std::atomic<quint64> m_dropped{0};
+};
+
+#endif // FRAMERING_H
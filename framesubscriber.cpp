@@ -0,0 +1,317 @@
+#include "framesubscriber.h"
+#include "metricsregistry.h"
+
+#include <QStringList>
+#include <QThread>
+
+namespace {
+// Frames a batch buffer holds before it has to grow, a few event loop iterations at 1 kHz
+const int BatchReserve = 256;
+}
+
+PublishPolicy PublishPolicy::fromString(const QString &deadband, bool changeOnly, double maxRateHz)
+{
+    PublishPolicy policy;
+    policy.changeOnly = changeOnly;
+    policy.maxRateHz = maxRateHz;
+
+    // Either one value for all channels or a comma separated value per channel
+    const QStringList values = deadband.split(',');
+    for (int ch = 0; ch < FingerFrame::MaxChannels; ++ch) {
+        const QString v = values.size() == 1 ? values.at(0) : (ch < values.size() ? values.at(ch) : QString());
+        policy.deadband[ch] = qMax(0.0f, v.trimmed().toFloat());
+    }
+
+    return policy;
+}
+
+PublishPolicy::Backpressure PublishPolicy::backpressureFromString(const QString &name)
+{
+    const QString n = name.trimmed().toLower();
+    if (n == "dropoldest")
+        return DropOldest;
+    if (n == "dropnewest")
+        return DropNewest;
+    if (n == "coalesce")
+        return Coalesce;
+    if (n == "block")
+        return Block;
+
+    return Unbounded;
+}
+
+quint64 FrameSubscriber::Counters::suppressed() const
+{
+    return suppressedDeadband + coalesced;
+}
+
+FrameSubscriber::FrameSubscriber(QObject *parent):
+    FrameSubscriber(PublishPolicy(), parent)
+{
+}
+
+FrameSubscriber::FrameSubscriber(const PublishPolicy &policy, QObject *parent):
+    QObject(parent)
+{
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_flushTimer, &QTimer::timeout, this, &FrameSubscriber::flushPending);
+
+    m_batchTimer.setSingleShot(true);
+    m_batchTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_batchTimer, &QTimer::timeout, this, &FrameSubscriber::flushBatch);
+    m_batches[0].reserve(BatchReserve);
+    m_batches[1].reserve(BatchReserve);
+
+    setPolicy(policy);
+}
+
+void FrameSubscriber::setPolicy(const PublishPolicy &policy)
+{
+    m_policy = policy;
+    m_minIntervalUs = policy.maxRateHz > 0.0 ? static_cast<qint64>(1e6 / policy.maxRateHz) : 0;
+    resizeQueue(policy.backpressure == PublishPolicy::Unbounded ? 0
+                : policy.backpressure == PublishPolicy::Coalesce ? 1 : qMax(1, policy.queueDepth));
+
+    if (m_minIntervalUs == 0 && m_hasPending)
+        flushPending();
+    if (policy.delivery != PublishPolicy::Batched && !m_batches[m_batchIndex].isEmpty())
+        flushBatch();
+}
+
+PublishPolicy FrameSubscriber::policy() const
+{
+    return m_policy;
+}
+
+FrameSubscriber::Counters FrameSubscriber::counters() const
+{
+    QMutexLocker locker(&m_queueMutex);
+    return m_counters;
+}
+
+void FrameSubscriber::resetCounters()
+{
+    QMutexLocker locker(&m_queueMutex);
+    m_counters = Counters();
+}
+
+int FrameSubscriber::pending() const
+{
+    return m_batches[m_batchIndex].size() + (m_hasPending ? 1 : 0) + queued();
+}
+
+int FrameSubscriber::queued() const
+{
+    QMutexLocker locker(&m_queueMutex);
+    return m_queueSize;
+}
+
+void FrameSubscriber::setDeliveryThread(QThread *thread)
+{
+    m_deliveryContext.moveToThread(thread ? thread : this->thread());
+}
+
+void FrameSubscriber::setDropCounter(Counter *counter)
+{
+    QMutexLocker locker(&m_queueMutex);
+    m_dropCounter = counter;
+}
+
+void FrameSubscriber::offer(const FingerFrame &frame)
+{
+    count(&Counters::offered);
+
+    if (m_hasPublished && m_policy.changeOnly && !movedPastDeadband(frame)) {
+        count(&Counters::suppressedDeadband);
+        return;
+    }
+
+    if (m_minIntervalUs > 0 && m_hasPublished) {
+        const qint64 sinceLast = frame.timestampUs - m_lastPublished.timestampUs;
+        if (sinceLast < m_minIntervalUs) {
+            // Keep only the latest value until the rate limit allows it out
+            if (m_hasPending)
+                count(&Counters::coalesced);
+            m_pending = frame;
+            m_hasPending = true;
+
+            if (!m_flushTimer.isActive())
+                m_flushTimer.start(static_cast<int>((m_minIntervalUs - sinceLast + 999) / 1000));
+            return;
+        }
+    }
+
+    if (m_hasPending) {
+        count(&Counters::coalesced);
+        m_hasPending = false;
+        m_flushTimer.stop();
+    }
+
+    publish(frame);
+}
+
+void FrameSubscriber::flushPending()
+{
+    if (!m_hasPending)
+        return;
+
+    m_hasPending = false;
+    publish(m_pending);
+}
+
+bool FrameSubscriber::movedPastDeadband(const FingerFrame &frame) const
+{
+    if (frame.channelCount != m_lastPublished.channelCount)
+        return true;
+
+    for (int ch = 0; ch < frame.channelCount; ++ch) {
+        if (qAbs(frame.channels[ch] - m_lastPublished.channels[ch]) > m_policy.deadband[ch])
+            return true;
+    }
+
+    return false;
+}
+
+void FrameSubscriber::flushBatch()
+{
+    const FrameBatch &frames = m_batches[m_batchIndex];
+    if (frames.isEmpty())
+        return;
+
+    // Receivers share the filled buffer without copying, the other one takes the next frames.
+    // clear() keeps its capacity once no queued receiver holds it any more. A still shared
+    // buffer would be copied just to be cleared, it is replaced by a new one instead
+    m_batchIndex = 1 - m_batchIndex;
+    FrameBatch &next = m_batches[m_batchIndex];
+    if (next.isDetached()) {
+        next.clear();
+    } else {
+        next = FrameBatch();
+        next.reserve(BatchReserve);
+    }
+    count(&Counters::batches);
+
+    emit framesReady(frames);
+}
+
+void FrameSubscriber::publish(const FingerFrame &frame)
+{
+    m_lastPublished = frame;
+    m_hasPublished = true;
+    count(&Counters::delivered);
+
+    if (m_policy.delivery == PublishPolicy::PerSample) {
+        if (m_policy.backpressure == PublishPolicy::Unbounded)
+            emit frameReady(frame);
+        else
+            enqueue(frame);
+        return;
+    }
+
+    // Zero interval timer fires once the event loop has drained pending events
+    m_batches[m_batchIndex].append(frame);
+    if (!m_batchTimer.isActive())
+        m_batchTimer.start(m_policy.batchIntervalMs);
+}
+
+void FrameSubscriber::resizeQueue(int depth)
+{
+    QMutexLocker locker(&m_queueMutex);
+    if (depth == m_queue.size())
+        return;
+
+    // Keep the newest frames that still fit
+    QVector<FingerFrame> queue(depth);
+    const int keep = qMin(m_queueSize, depth);
+    for (int i = 0; i < keep; ++i)
+        queue[i] = m_queue.at((m_queueHead + m_queueSize - keep + i) % m_queue.size());
+
+    countDropped(m_queueSize - keep);
+    m_queue.swap(queue);
+    m_queueHead = 0;
+    m_queueSize = keep;
+    m_queueNotFull.wakeAll();
+}
+
+void FrameSubscriber::enqueue(const FingerFrame &frame)
+{
+    // Without a thread boundary blocking means the receiver runs before the producer goes on,
+    // frames still queued from an earlier delivery thread go first
+    if (m_policy.backpressure == PublishPolicy::Block && m_deliveryContext.thread() == QThread::currentThread()) {
+        drainQueue();
+        emit frameReady(frame);
+        return;
+    }
+
+    QMutexLocker locker(&m_queueMutex);
+    const int depth = m_queue.size();
+
+    if (m_queueSize == depth) {
+        switch (m_policy.backpressure) {
+        case PublishPolicy::DropNewest:
+            countDropped(1);
+            return;
+        case PublishPolicy::DropOldest:
+        case PublishPolicy::Coalesce:
+            m_queueHead = (m_queueHead + 1) % depth;
+            m_queueSize--;
+            countDropped(1);
+            break;
+        case PublishPolicy::Block:
+            m_counters.queueBlocked++;
+            while (m_queueSize == m_queue.size())
+                m_queueNotFull.wait(&m_queueMutex);
+            break;
+        case PublishPolicy::Unbounded:
+            break;
+        }
+    }
+
+    m_queue[(m_queueHead + m_queueSize) % m_queue.size()] = frame;
+    m_queueSize++;
+    m_counters.queueHighWater = qMax(m_counters.queueHighWater, m_queueSize);
+
+    // One wakeup per burst, the receiver drains everything queued by then
+    if (m_drainScheduled)
+        return;
+    m_drainScheduled = true;
+    locker.unlock();
+    QTimer::singleShot(0, &m_deliveryContext, [this]() { drainQueue(); });
+}
+
+void FrameSubscriber::drainQueue()
+{
+    for (;;) {
+        FingerFrame frame;
+        {
+            QMutexLocker locker(&m_queueMutex);
+            if (m_queueSize == 0) {
+                m_drainScheduled = false;
+                return;
+            }
+
+            frame = m_queue.at(m_queueHead);
+            m_queueHead = (m_queueHead + 1) % m_queue.size();
+            m_queueSize--;
+            m_queueNotFull.wakeAll();
+        }
+
+        emit frameReady(frame);
+    }
+}
+
+void FrameSubscriber::count(quint64 Counters::*counter)
+{
+    // counters() is read from other threads
+    QMutexLocker locker(&m_queueMutex);
+    ++(m_counters.*counter);
+}
+
+void FrameSubscriber::countDropped(int frames)
+{
+    // Called with the queue mutex held
+    m_counters.queueDropped += static_cast<quint64>(frames);
+    if (m_dropCounter && frames > 0)
+        m_dropCounter->increment(static_cast<quint64>(frames));
+}
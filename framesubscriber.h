@@ -0,0 +1,138 @@
+#ifndef FRAMESUBSCRIBER_H
+#define FRAMESUBSCRIBER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "fingerframe.h"
+
+class Counter;
+
+// Contiguous run of frames delivered with a single signal
+typedef QVector<FingerFrame> FrameBatch;
+
+// Decides which frames of the sample stream reach a consumer and how
+struct PublishPolicy
+{
+    enum Delivery {
+        PerSample,      // frameReady for every published frame
+        Batched         // framesReady once per batch interval
+    };
+
+    // What a full delivery queue does with the next frame, applies to frameReady
+    enum Backpressure {
+        Unbounded,      // emit right away, a queued receiver's event queue grows freely
+        DropOldest,
+        DropNewest,
+        Coalesce,       // only the latest frame waits
+        Block           // producer waits for room, for lossless recording sinks
+    };
+
+    bool changeOnly = false;                            // drop frames that did not move past the deadband
+    float deadband[FingerFrame::MaxChannels] = {};      // per channel, in raw units
+    double maxRateHz = 0.0;                             // 0 -> unlimited, otherwise latest value is coalesced
+
+    Delivery delivery = PerSample;
+    int batchIntervalMs = 0;                            // 0 -> one batch per event loop iteration
+
+    Backpressure backpressure = Unbounded;
+    int queueDepth = 64;                                // frames waiting for the receiver at most
+
+    static PublishPolicy fromString(const QString &deadband, bool changeOnly, double maxRateHz);
+    static Backpressure backpressureFromString(const QString &name);
+};
+
+// Per-consumer publisher with its own PublishPolicy. Connect to frameReady
+// (or framesReady for batched delivery) instead of CaptoGloveAPI::frameReceived
+// to receive the filtered stream.
+// With a Backpressure other than Unbounded frameReady is emitted from a bounded
+// queue drained on the delivery thread, so a slow receiver only delays itself.
+// The queue is the boundary to the consumer: set the delivery thread to the
+// receiver's thread, a receiver on the producer's thread gets Block as a direct
+// call. Delete the subscriber only after its delivery thread stopped.
+class FrameSubscriber : public QObject
+{
+    Q_OBJECT
+public:
+    struct Counters {
+        quint64 offered = 0;
+        quint64 delivered = 0;
+        quint64 suppressedDeadband = 0;     // did not move enough
+        quint64 coalesced = 0;              // replaced by a newer frame before the rate limit allowed it out
+        quint64 batches = 0;
+        quint64 queueDropped = 0;           // discarded or replaced by the backpressure policy
+        quint64 queueBlocked = 0;           // times the producer waited for room
+        int queueHighWater = 0;
+
+        quint64 suppressed() const;
+    };
+
+    FrameSubscriber(QObject *parent = nullptr);
+    FrameSubscriber(const PublishPolicy &policy, QObject *parent = nullptr);
+
+    void setPolicy(const PublishPolicy &policy);
+    PublishPolicy policy() const;
+    Counters counters() const;
+    void resetCounters();
+    int pending() const;                    // frames held back for rate limiting, batching or the receiver
+    int queued() const;                     // frames waiting in the delivery queue
+
+    // Thread frameReady is emitted on for bounded delivery, nullptr is the subscriber's own
+    void setDeliveryThread(QThread *thread);
+    // Also incremented for every frame the backpressure policy discards, may be shared
+    void setDropCounter(Counter *counter);
+
+public slots:
+    void offer(const FingerFrame &frame);
+
+Q_SIGNALS:
+    void frameReady(const FingerFrame &frame);
+    void framesReady(const FrameBatch &frames);
+
+private slots:
+    void flushPending();
+    void flushBatch();
+
+private:
+    bool movedPastDeadband(const FingerFrame &frame) const;
+    void publish(const FingerFrame &frame);
+    void resizeQueue(int depth);
+    void enqueue(const FingerFrame &frame);
+    void drainQueue();
+    void count(quint64 Counters::*counter);
+    void countDropped(int frames);
+
+    PublishPolicy m_policy;
+    qint64 m_minIntervalUs = 0;
+    Counters m_counters;
+
+    bool m_hasPublished = false;
+    FingerFrame m_lastPublished;
+    bool m_hasPending = false;
+    FingerFrame m_pending;
+    QTimer m_flushTimer;
+
+    // Batch being filled and the one handed out last time. The handed out one is
+    // reused if its receivers let go of it by the next flush, else replaced
+    FrameBatch m_batches[2];
+    int m_batchIndex = 0;
+    QTimer m_batchTimer;
+
+    // Bounded delivery, ring of queueDepth frames shared with the delivery thread.
+    // Also guards m_counters
+    mutable QMutex m_queueMutex;
+    QWaitCondition m_queueNotFull;
+    QVector<FingerFrame> m_queue;
+    int m_queueHead = 0;
+    int m_queueSize = 0;
+    bool m_drainScheduled = false;
+    QObject m_deliveryContext;
+    Counter *m_dropCounter = nullptr;
+};
+
+Q_DECLARE_METATYPE(FrameBatch)
+
+#endif // FRAMESUBSCRIBER_H
@@ -0,0 +1,105 @@
+#ifndef GLOVESTATE_H
+#define GLOVESTATE_H
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+#include "fingerframe.h"
+#include "handmodel.h"
+
+// Newest values of one glove, taken as one consistent record. Timestamps are
+// on the clock of FingerFrame::timestampUs.
+struct GloveState
+{
+    enum Connection { Idle, Connecting, Streaming, Stalled, Disconnected };
+
+    static const int MaxPayload = 32;
+    static const int MaxName = 32;
+
+    FingerFrame frame;
+    HandPose pose;
+    uchar payload[MaxPayload] = {};     // raw finger notification of frame
+    int payloadSize = 0;
+
+    int battery = -1;                   // percent, -1 unknown
+    qint64 batteryUs = 0;
+    int rssi = 0;                       // dBm at discovery, 0 unknown
+    int connection = Idle;
+    qint64 connectionUs = 0;
+    char deviceName[MaxName] = {};      // UTF-8, zero terminated
+
+    quint64 updates = 0;                // publish() count
+};
+
+// Seqlock over two copies of GloveState. The Qt thread edits staging() and
+// publishes it into the copy readers are not pointed at, then flips the
+// index. read() from any thread never locks or allocates and only retries if
+// two publishes land while it copies, which at notification rates doesn't
+// happen. The record is moved as relaxed atomic words, so a torn copy is
+// detected by the slot sequence instead of being a data race.
+class GloveStateBlock
+{
+public:
+    GloveStateBlock()
+    {
+        publish();
+    }
+
+    // Writer side, one thread
+    GloveState &staging() { return m_staging; }
+
+    void publish()
+    {
+        m_staging.updates++;
+        quint64 words[WordCount] = {};
+        memcpy(words, &m_staging, sizeof(GloveState));
+
+        const int index = 1 - m_current.load(std::memory_order_relaxed);
+        Slot &slot = m_slots[index];
+        const quint32 sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (int i = 0; i < WordCount; ++i)
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+
+        m_current.store(index, std::memory_order_release);
+    }
+
+    // Any thread
+    GloveState read() const
+    {
+        quint64 words[WordCount];
+        for (;;) {
+            const Slot &slot = m_slots[m_current.load(std::memory_order_acquire)];
+            const quint32 before = slot.sequence.load(std::memory_order_acquire);
+            if (before & 1)
+                continue;
+            for (int i = 0; i < WordCount; ++i)
+                words[i] = slot.words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == before)
+                break;
+        }
+
+        GloveState state;
+        memcpy(&state, words, sizeof(GloveState));
+        return state;
+    }
+
+private:
+    static_assert(std::is_trivially_copyable<GloveState>::value, "GloveState is copied as raw words");
+    static const int WordCount = (sizeof(GloveState) + sizeof(quint64) - 1) / sizeof(quint64);
+
+    struct Slot {
+        std::atomic<quint32> sequence{0};
+        std::atomic<quint64> words[WordCount];
+    };
+
+    GloveState m_staging;
+    Slot m_slots[2];
+    std::atomic<int> m_current{0};
+};
+
+#endif // GLOVESTATE_H
@@ -0,0 +1,158 @@
+#include "handmodel.h"
+
+#include <cmath>
+
+namespace {
+
+const float Deg = 3.14159265f / 180.0f;
+
+// Average adult hand, knuckle positions relative to the wrist
+const float DefaultBase[HandPose::FingerCount][3] = {
+    { -0.035f, 0.030f, 0.0f },
+    { -0.022f, 0.090f, 0.0f },
+    {  0.000f, 0.095f, 0.0f },
+    {  0.019f, 0.090f, 0.0f },
+    {  0.036f, 0.080f, 0.0f }
+};
+
+const float DefaultSegments[HandPose::FingerCount][HandPose::JointCount] = {
+    { 0.040f, 0.032f, 0.000f },     // thumb has no middle phalanx
+    { 0.040f, 0.025f, 0.020f },
+    { 0.045f, 0.028f, 0.022f },
+    { 0.042f, 0.027f, 0.021f },
+    { 0.033f, 0.020f, 0.018f }
+};
+
+// DIP follows PIP at roughly 2/3 in natural grasps
+const float DefaultMaxAngles[HandPose::FingerCount][HandPose::JointCount] = {
+    { 50.0f * Deg,  80.0f * Deg,  0.0f * Deg },
+    { 90.0f * Deg, 110.0f * Deg, 70.0f * Deg },
+    { 90.0f * Deg, 110.0f * Deg, 70.0f * Deg },
+    { 90.0f * Deg, 110.0f * Deg, 70.0f * Deg },
+    { 90.0f * Deg, 110.0f * Deg, 70.0f * Deg }
+};
+
+// Six channel CaptoGlove, channel 3 isn't a finger
+const int DefaultChannels[HandPose::FingerCount] = { 0, 1, 2, 4, 5 };
+
+}
+
+HandModel::HandModel()
+{
+    for (int f = 0; f < HandPose::FingerCount; ++f) {
+        m_channels[f] = DefaultChannels[f];
+        for (int k = 0; k < 3; ++k)
+            m_base[f][k] = DefaultBase[f][k];
+        for (int j = 0; j < HandPose::JointCount; ++j) {
+            m_segments[f][j] = DefaultSegments[f][j];
+            m_maxAngles[f][j] = DefaultMaxAngles[f][j];
+        }
+    }
+
+    buildTables();
+}
+
+void HandModel::setChannels(const int channels[HandPose::FingerCount])
+{
+    for (int f = 0; f < HandPose::FingerCount; ++f)
+        m_channels[f] = qBound(0, channels[f], FingerFrame::MaxChannels - 1);
+
+    buildTables();
+}
+
+int HandModel::channel(int finger, int channelCount) const
+{
+    return mappedChannel(channelMap(channelCount), finger);
+}
+
+HandModel::ChannelMap HandModel::channelMap(int channelCount) const
+{
+    // Remapping only some fingers would read one channel twice and skip another
+    return m_maxChannel < channelCount ? Mapped : Identity;
+}
+
+int HandModel::mappedChannel(ChannelMap map, int finger) const
+{
+    return map == Mapped ? m_channels[finger] : finger;
+}
+
+void HandModel::setCalibration(const CalibrationProfile &profile)
+{
+    m_profile = profile;
+    buildTables();
+}
+
+const CalibrationProfile &HandModel::calibration() const
+{
+    return m_profile;
+}
+
+void HandModel::setRanges(const float *minimum, const float *maximum, const float *rest)
+{
+    for (int ch = 0; ch < FingerFrame::MaxChannels; ++ch) {
+        m_profile.minimum[ch] = minimum[ch];
+        m_profile.maximum[ch] = maximum[ch];
+        m_profile.rest[ch] = rest[ch];
+    }
+}
+
+void HandModel::evaluate(const FingerFrame &frame, HandPose &pose) const
+{
+    pose.sequence = frame.sequence;
+    pose.timestampUs = frame.timestampUs;
+
+    const ChannelMap map = channelMap(frame.channelCount);
+    for (int f = 0; f < HandPose::FingerCount; ++f) {
+        const int ch = mappedChannel(map, f);
+        const float raw = ch < frame.channelCount ? frame.channels[ch] : m_profile.rest[ch];
+        const float x = m_profile.normalize(ch, raw) * (TableSize - 1);
+        const int i = qMin(static_cast<int>(x), TableSize - 2);
+        const float w = x - i;
+        const float *a = m_table[map][f][i];
+        const float *b = m_table[map][f][i + 1];
+
+        float row[RowSize];
+        for (int k = 0; k < RowSize; ++k)
+            row[k] = a[k] + (b[k] - a[k]) * w;
+
+        pose.flexion[f] = row[0];
+        for (int j = 0; j < HandPose::JointCount; ++j)
+            pose.jointAngles[f][j] = row[1 + j];
+        for (int k = 0; k < 3; ++k)
+            pose.fingertips[f][k] = row[1 + HandPose::JointCount + k];
+    }
+}
+
+void HandModel::buildTables()
+{
+    m_maxChannel = 0;
+    for (int f = 0; f < HandPose::FingerCount; ++f)
+        m_maxChannel = qMax(m_maxChannel, m_channels[f]);
+
+    // Rows are indexed by normalized sensor value, joints bend together
+    for (int map = 0; map < MapCount; ++map) {
+        for (int f = 0; f < HandPose::FingerCount; ++f) {
+            const int ch = mappedChannel(static_cast<ChannelMap>(map), f);
+            for (int i = 0; i < TableSize; ++i) {
+                const float flexion = m_profile.response(ch, static_cast<float>(i) / (TableSize - 1));
+                float *row = m_table[map][f][i];
+
+                row[0] = flexion;
+
+                float y = m_base[f][1];
+                float z = m_base[f][2];
+                float bend = 0.0f;
+                for (int j = 0; j < HandPose::JointCount; ++j) {
+                    row[1 + j] = flexion * m_maxAngles[f][j];
+                    bend += row[1 + j];
+                    y += m_segments[f][j] * std::cos(bend);
+                    z -= m_segments[f][j] * std::sin(bend);
+                }
+
+                row[1 + HandPose::JointCount] = m_base[f][0];
+                row[2 + HandPose::JointCount] = y;
+                row[3 + HandPose::JointCount] = z;
+            }
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef HANDMODEL_H
+#define HANDMODEL_H
+
+#include <QtGlobal>
+#include <QMetaType>
+
+#include "fingerframe.h"
+#include "calibrationprofile.h"
+
+// Fixed layout hand pose, ready for retargeting
+struct HandPose
+{
+    enum Finger { Thumb, Index, Middle, Ring, Little, FingerCount };
+    enum Joint { MCP, PIP, DIP, JointCount };
+
+    quint64 sequence = 0;
+    qint64 timestampUs = 0;
+    float flexion[FingerCount] = {};                    // calibrated, 0 open - 1 fully bent
+    float jointAngles[FingerCount][JointCount] = {};    // radians, positive is flexion
+    float fingertips[FingerCount][3] = {};              // metres in hand frame, x right, y along fingers, z back of hand
+};
+
+Q_DECLARE_METATYPE(HandPose)
+
+// Maps calibrated flex readings to joint angles and fingertip positions.
+// Sensor response, joint angles and forward kinematics are tabulated once per
+// calibration so evaluate() only normalizes and interpolates between table rows.
+class HandModel
+{
+public:
+    HandModel();
+
+    void setChannels(const int channels[HandPose::FingerCount]);
+    // Frame channel of finger. When any mapped channel is past the end of a narrower
+    // frame the whole hand falls back to channels 0-4, so 5 channel formats work unmapped
+    int channel(int finger, int channelCount) const;
+    void setCalibration(const CalibrationProfile &profile);
+    const CalibrationProfile &calibration() const;
+    // Only the normalization changes, cheap enough per frame
+    void setRanges(const float *minimum, const float *maximum, const float *rest);
+
+    void evaluate(const FingerFrame &frame, HandPose &pose) const;
+
+private:
+    static const int TableSize = 65;
+    static const int RowSize = 1 + HandPose::JointCount + 3;     // flexion, joint angles, fingertip
+
+    // Tables of the configured channels and of the fallback to channels 0-4
+    enum ChannelMap { Mapped, Identity, MapCount };
+
+    ChannelMap channelMap(int channelCount) const;
+    int mappedChannel(ChannelMap map, int finger) const;
+    void buildTables();
+
+    int m_channels[HandPose::FingerCount];
+    int m_maxChannel = 0;                   // highest configured channel
+    CalibrationProfile m_profile;
+
+    // Hand geometry, metres and radians
+    float m_base[HandPose::FingerCount][3];
+    float m_segments[HandPose::FingerCount][HandPose::JointCount];
+    float m_maxAngles[HandPose::FingerCount][HandPose::JointCount];
+
+    float m_table[MapCount][HandPose::FingerCount][TableSize][RowSize];
+};
+
+#endif // HANDMODEL_H
@@ -0,0 +1,109 @@
+#include "listingsnapshot.h"
+#include "deviceinfo.h"
+#include "serviceinfo.h"
+#include "characteristicinfo.h"
+
+#include <QHash>
+#include <QMutexLocker>
+
+ListingRow ListingRow::device(const DeviceInfo &device)
+{
+    ListingRow row;
+    row.key = device.getAddress();
+    row.fields.insert(QStringLiteral("deviceName"), device.getName());
+    row.fields.insert(QStringLiteral("deviceAddress"), row.key);
+    return row;
+}
+
+ListingRow ListingRow::service(const ServiceInfo &service)
+{
+    ListingRow row;
+    row.key = service.getUuid();
+    row.fields.insert(QStringLiteral("serviceName"), service.getName());
+    row.fields.insert(QStringLiteral("serviceUuid"), row.key);
+    row.fields.insert(QStringLiteral("serviceType"), service.getType());
+    return row;
+}
+
+ListingRow ListingRow::characteristic(const CharacteristicRecord &record)
+{
+    ListingRow row;
+    row.key = QString("%1/%2").arg(record.service.toString()).arg(record.handle);
+    row.fields.insert(QStringLiteral("characteristicName"), record.name.isEmpty() ? QStringLiteral("Unknown") : record.name);
+    row.fields.insert(QStringLiteral("characteristicUuid"), CharacteristicInfo::uuidToString(record.uuid));
+    row.fields.insert(QStringLiteral("characteristicValue"), CharacteristicInfo::valueToString(record.value));
+    row.fields.insert(QStringLiteral("characteristicHandle"), QStringLiteral("0x") + QString::number(record.handle, 16));
+    row.fields.insert(QStringLiteral("characteristicPermission"), CharacteristicInfo::propertiesToString(record.properties));
+    return row;
+}
+
+ListingModel::ListingModel():
+    m_snapshot(new ListingSnapshot())
+{
+}
+
+bool ListingModel::publish(const QVector<ListingRow> &rows)
+{
+    const ListingSnapshotPtr previous = snapshot();
+
+    QHash<QString, int> before;
+    before.reserve(previous->rows.size());
+    for (int i = 0; i < previous->rows.size(); ++i)
+        before.insert(previous->rows.at(i).key, i);
+
+    // Removing, then adding at the given indices turns the previous rows into these
+    QSharedPointer<ListingSnapshot> next(new ListingSnapshot());
+    QVector<bool> kept(previous->rows.size(), false);
+    int lastOld = -1;
+    bool reordered = false;
+    for (int i = 0; i < rows.size(); ++i) {
+        const int old = before.value(rows.at(i).key, -1);
+        if (old < 0) {
+            next->added.append(i);
+            continue;
+        }
+        kept[old] = true;
+        reordered |= old < lastOld;
+        lastOld = old;
+        if (previous->rows.at(old).fields != rows.at(i).fields)
+            next->changed.append(i);
+    }
+    for (int i = 0; i < kept.size(); ++i) {
+        if (!kept.at(i))
+            next->removed.append(i);
+    }
+
+    // Moved rows are rare, they are reported as a complete replacement
+    if (reordered) {
+        next->added.clear();
+        next->removed.clear();
+        next->changed.clear();
+        for (int i = 0; i < rows.size(); ++i)
+            next->added.append(i);
+        for (int i = 0; i < previous->rows.size(); ++i)
+            next->removed.append(i);
+    }
+
+    if (next->added.isEmpty() && next->removed.isEmpty() && next->changed.isEmpty())
+        return false;
+
+    // Display list is built once here, every reader of this version shares it
+    QVariantList list;
+    list.reserve(rows.size());
+    for (const ListingRow &row : rows)
+        list.append(row.fields);
+
+    next->version = previous->version + 1;
+    next->rows = rows;
+    next->list = list;
+
+    QMutexLocker locker(&m_mutex);
+    m_snapshot = next;
+    return true;
+}
+
+ListingSnapshotPtr ListingModel::snapshot() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_snapshot;
+}
@@ -0,0 +1,62 @@
+#ifndef LISTINGSNAPSHOT_H
+#define LISTINGSNAPSHOT_H
+
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+#include "characteristicregistry.h"
+
+class DeviceInfo;
+class ServiceInfo;
+
+// One row of the device, service or characteristic listing. Display fields
+// are formatted once when the row is built and carry the property names of
+// DeviceInfo, ServiceInfo and CharacteristicInfo, so delegates keep working.
+struct ListingRow
+{
+    QString key;                    // identity of the row across versions
+    QVariantMap fields;
+
+    static ListingRow device(const DeviceInfo &device);
+    static ListingRow service(const ServiceInfo &service);
+    static ListingRow characteristic(const CharacteristicRecord &record);
+};
+
+// Immutable listing at one version and what changed against the version before
+struct ListingSnapshot
+{
+    quint64 version = 0;
+    QVector<ListingRow> rows;
+    QVariant list;                  // QVariantList of the rows' fields
+
+    // removed indexes the previous version, added and changed index rows
+    QVector<int> added;
+    QVector<int> removed;
+    QVector<int> changed;
+};
+
+typedef QSharedPointer<const ListingSnapshot> ListingSnapshotPtr;
+
+Q_DECLARE_METATYPE(ListingSnapshotPtr)
+
+// Writer side of a listing. publish() diffs the rows against the current
+// snapshot by key and only makes a new version if anything changed. Readers
+// on any thread take the current snapshot and may keep it, a reader whose
+// version is not the previous one of a new snapshot reloads all rows.
+class ListingModel
+{
+public:
+    ListingModel();
+
+    bool publish(const QVector<ListingRow> &rows);
+    ListingSnapshotPtr snapshot() const;
+
+private:
+    mutable QMutex m_mutex;
+    ListingSnapshotPtr m_snapshot;
+};
+
+#endif // LISTINGSNAPSHOT_H
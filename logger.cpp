@@ -0,0 +1,398 @@
+#include "logger.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const char LevelTags[] = { 'T', 'D', 'I', 'W', 'E' };
+
+// Sleep of the logger thread when all rings are empty
+const std::chrono::milliseconds IdleWait(2);
+
+}
+
+// ############## RING ##############
+bool LogRing::push(const LogRecord &record)
+{
+    const quint32 head = m_head.load(std::memory_order_relaxed);
+    const quint32 tail = m_tail.load(std::memory_order_acquire);
+    if (head - tail >= static_cast<quint32>(Capacity)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    m_records[head % Capacity] = record;
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool LogRing::pop(LogRecord &record)
+{
+    const quint32 tail = m_tail.load(std::memory_order_relaxed);
+    const quint32 head = m_head.load(std::memory_order_acquire);
+    if (tail == head)
+        return false;
+
+    record = m_records[tail % Capacity];
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+quint64 LogRing::dropped() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+// ############## LOGGER ##############
+Logger *Logger::instance()
+{
+    static Logger logger;
+    return &logger;
+}
+
+Logger::Logger():
+    m_level(Debug),
+    m_running(true),
+    m_output(stderr)
+{
+    m_thread = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger()
+{
+    m_running.store(false);
+    if (m_thread.joinable())
+        m_thread.join();
+
+    drain();
+    if (m_output != stderr)
+        fclose(m_output);
+}
+
+void Logger::setLevel(Level level)
+{
+    m_level.store(level, std::memory_order_relaxed);
+}
+
+Logger::Level Logger::level() const
+{
+    return static_cast<Level>(m_level.load(std::memory_order_relaxed));
+}
+
+bool Logger::setOutputFile(const QString &path)
+{
+    FILE *output = stderr;
+    if (!path.isEmpty()) {
+        output = fopen(path.toLocal8Bit().constData(), "a");
+        if (!output)
+            return false;
+    }
+
+    QMutexLocker locker(&m_outputMutex);
+    if (m_output != stderr)
+        fclose(m_output);
+    m_output = output;
+    return true;
+}
+
+void Logger::flush()
+{
+    drain();
+}
+
+quint64 Logger::dropped() const
+{
+    Logger *self = const_cast<Logger *>(this);
+    QMutexLocker locker(&self->m_ringsMutex);
+
+    quint64 total = m_releasedDropped;
+    for (const LogRing *ring : m_rings)
+        total += ring->dropped();
+    return total;
+}
+
+Logger::Level Logger::levelFromString(const QString &name)
+{
+    const QString level = name.trimmed().toLower();
+    if (level == "trace")
+        return Trace;
+    if (level == "debug")
+        return Debug;
+    if (level == "info")
+        return Info;
+    if (level == "warning")
+        return Warning;
+    if (level == "error")
+        return Error;
+    if (level == "off")
+        return Off;
+
+    return Debug;
+}
+
+void Logger::setArg(LogRecord &record, int value)
+{
+    setArg(record, static_cast<qint64>(value));
+}
+
+void Logger::setArg(LogRecord &record, uint value)
+{
+    setArg(record, static_cast<quint64>(value));
+}
+
+void Logger::setArg(LogRecord &record, long value)
+{
+    setArg(record, static_cast<qint64>(value));
+}
+
+void Logger::setArg(LogRecord &record, unsigned long value)
+{
+    setArg(record, static_cast<quint64>(value));
+}
+
+void Logger::setArg(LogRecord &record, qint64 value)
+{
+    record.types[record.argCount] = LogRecord::Int;
+    record.args[record.argCount++].i = value;
+}
+
+void Logger::setArg(LogRecord &record, quint64 value)
+{
+    record.types[record.argCount] = LogRecord::UInt;
+    record.args[record.argCount++].u = value;
+}
+
+void Logger::setArg(LogRecord &record, double value)
+{
+    record.types[record.argCount] = LogRecord::Double;
+    record.args[record.argCount++].d = value;
+}
+
+void Logger::setArg(LogRecord &record, bool value)
+{
+    setArg(record, value ? "true" : "false");
+}
+
+void Logger::setArg(LogRecord &record, const char *literal)
+{
+    record.types[record.argCount] = LogRecord::Literal;
+    record.args[record.argCount++].s = literal;
+}
+
+void Logger::setArg(LogRecord &record, const QString &text)
+{
+    // Encoded straight into the record, toUtf8() would allocate. Truncated at a whole character
+    const int offset = record.textUsed;
+    const int room = LogRecord::TextSize - offset - 1;
+    char *out = record.text + offset;
+    const QChar *data = text.constData();
+    const int size = text.size();
+
+    int written = 0;
+    for (int i = 0; i < size; ++i) {
+        uint c = data[i].unicode();
+        if (QChar::isSurrogate(c)) {
+            if (QChar::isHighSurrogate(c) && i + 1 < size && QChar::isLowSurrogate(data[i + 1].unicode()))
+                c = QChar::surrogateToUcs4(static_cast<ushort>(c), data[++i].unicode());
+            else
+                c = '?';
+        }
+
+        const int bytes = c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+        if (written + bytes > room)
+            break;
+        switch (bytes) {
+        case 1:
+            out[written++] = static_cast<char>(c);
+            break;
+        case 2:
+            out[written++] = static_cast<char>(0xc0 | (c >> 6));
+            out[written++] = static_cast<char>(0x80 | (c & 0x3f));
+            break;
+        case 3:
+            out[written++] = static_cast<char>(0xe0 | (c >> 12));
+            out[written++] = static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+            out[written++] = static_cast<char>(0x80 | (c & 0x3f));
+            break;
+        default:
+            out[written++] = static_cast<char>(0xf0 | (c >> 18));
+            out[written++] = static_cast<char>(0x80 | ((c >> 12) & 0x3f));
+            out[written++] = static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+            out[written++] = static_cast<char>(0x80 | (c & 0x3f));
+            break;
+        }
+    }
+
+    finishText(record, offset, written);
+}
+
+void Logger::setArg(LogRecord &record, const QByteArray &bytes)
+{
+    setText(record, bytes.constData(), bytes.size(), true);
+}
+
+void Logger::setText(LogRecord &record, const char *data, int size, bool hex)
+{
+    // Stored as offset into the record's inline text, truncated when full
+    const int offset = record.textUsed;
+    const int room = LogRecord::TextSize - offset - 1;
+    char *out = record.text + offset;
+
+    int written = 0;
+    if (hex) {
+        static const char Digits[] = "0123456789abcdef";
+        for (int i = 0; i < size && written + 2 <= room; ++i) {
+            const uchar b = static_cast<uchar>(data[i]);
+            out[written++] = Digits[b >> 4];
+            out[written++] = Digits[b & 0x0f];
+        }
+    } else {
+        written = qMax(0, qMin(size, room));
+        memcpy(out, data, static_cast<size_t>(written));
+    }
+
+    finishText(record, offset, written);
+}
+
+void Logger::finishText(LogRecord &record, int offset, int written)
+{
+    const int room = LogRecord::TextSize - offset - 1;
+    char *out = record.text + offset;
+    if (room >= 0)
+        out[written] = '\0';
+    record.textUsed = static_cast<quint8>(qMin(offset + written + 1, static_cast<int>(LogRecord::TextSize)));
+
+    record.types[record.argCount] = LogRecord::Text;
+    record.args[record.argCount++].u = static_cast<quint64>(qMin(offset, LogRecord::TextSize - 1));
+}
+
+qint64 Logger::now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Logger::submit(const LogRecord &record)
+{
+    threadRing()->push(record);
+}
+
+// Owns the ring of one thread and gives it back when the thread exits, so
+// short lived workers don't leave rings behind for every drain to walk
+struct LogRingHolder
+{
+    LogRing *ring = nullptr;
+
+    ~LogRingHolder()
+    {
+        if (ring)
+            Logger::instance()->releaseRing(ring);
+    }
+};
+
+LogRing *Logger::threadRing()
+{
+    static thread_local LogRingHolder holder;
+    if (!holder.ring) {
+        holder.ring = new LogRing;
+        QMutexLocker locker(&m_ringsMutex);
+        m_rings.append(holder.ring);
+    }
+
+    return holder.ring;
+}
+
+void Logger::releaseRing(LogRing *ring)
+{
+    // Same lock order as drain(), which may be popping from this ring right now
+    QMutexLocker outputLocker(&m_outputMutex);
+    LogRecord record;
+    int count = 0;
+    while (ring->pop(record)) {
+        write(record);
+        ++count;
+    }
+    if (count > 0)
+        fflush(m_output);
+
+    {
+        QMutexLocker locker(&m_ringsMutex);
+        m_rings.removeOne(ring);
+        m_releasedDropped += ring->dropped();
+    }
+    delete ring;
+}
+
+void Logger::run()
+{
+    while (m_running.load()) {
+        if (drain() == 0)
+            std::this_thread::sleep_for(IdleWait);
+    }
+}
+
+int Logger::drain()
+{
+    // Rings are single consumer, the output mutex serializes flush() and the logger thread
+    QMutexLocker outputLocker(&m_outputMutex);
+
+    m_ringsMutex.lock();
+    const QList<LogRing *> rings = m_rings;
+    m_ringsMutex.unlock();
+
+    int count = 0;
+    LogRecord record;
+    for (LogRing *ring : rings) {
+        while (ring->pop(record)) {
+            write(record);
+            ++count;
+        }
+    }
+
+    if (count > 0)
+        fflush(m_output);
+
+    return count;
+}
+
+void Logger::write(const LogRecord &record)
+{
+    QString args[LogRecord::MaxArgs];
+    for (int i = 0; i < record.argCount; ++i) {
+        const LogRecord::ArgValue &arg = record.args[i];
+        switch (record.types[i]) {
+        case LogRecord::Int:
+            args[i] = QString::number(arg.i);
+            break;
+        case LogRecord::UInt:
+            args[i] = QString::number(arg.u);
+            break;
+        case LogRecord::Double:
+            args[i] = QString::number(arg.d);
+            break;
+        case LogRecord::Literal:
+            args[i] = QString::fromLatin1(arg.s);
+            break;
+        case LogRecord::Text:
+            args[i] = QString::fromUtf8(record.text + arg.u);
+            break;
+        }
+    }
+
+    // One pass over the format, so a %N inside an argument (device names, errors) stays as it is
+    QString message;
+    for (const char *c = record.format; *c; ++c) {
+        const int n = c[0] == '%' ? c[1] - '0' : 0;
+        if (n >= 1 && n <= record.argCount) {
+            message += args[n - 1];
+            ++c;
+        } else {
+            message += QLatin1Char(*c);
+        }
+    }
+
+    const char tag = record.level < sizeof(LevelTags) ? LevelTags[record.level] : '?';
+    fprintf(m_output, "[%12.6f] %c %s\n", record.timestampUs / 1e6, tag, message.toUtf8().constData());
+}
@@ -0,0 +1,152 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+#include <QList>
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+// Level check happens before any argument is evaluated
+#define LOG_AT(level, ...) \
+    do { if (Logger::instance()->isEnabled(level)) Logger::instance()->log(level, __VA_ARGS__); } while (0)
+
+#define LOG_TRACE(...)      LOG_AT(Logger::Trace, __VA_ARGS__)
+#define LOG_DEBUG(...)      LOG_AT(Logger::Debug, __VA_ARGS__)
+#define LOG_INFO(...)       LOG_AT(Logger::Info, __VA_ARGS__)
+#define LOG_WARNING(...)    LOG_AT(Logger::Warning, __VA_ARGS__)
+#define LOG_ERROR(...)      LOG_AT(Logger::Error, __VA_ARGS__)
+
+// Fixed size binary log entry. format must be a string literal with %1..%4
+// placeholders, it is only expanded on the logger thread.
+struct LogRecord
+{
+    static const int MaxArgs = 4;
+    static const int TextSize = 48;
+
+    enum ArgType : quint8 { Int, UInt, Double, Literal, Text };
+
+    union ArgValue {
+        qint64 i;
+        quint64 u;
+        double d;
+        const char *s;
+    };
+
+    qint64 timestampUs;
+    const char *format;
+    quint8 level;
+    quint8 argCount;
+    quint8 textUsed;
+    ArgType types[MaxArgs];
+    ArgValue args[MaxArgs];
+    char text[TextSize];        // inline copies of runtime strings, truncated
+};
+
+// Single producer / single consumer ring owned by one logging thread
+class LogRing
+{
+public:
+    static const int Capacity = 1024;
+
+    bool push(const LogRecord &record);
+    bool pop(LogRecord &record);
+    quint64 dropped() const;
+
+private:
+    LogRecord m_records[Capacity];
+    std::atomic<quint32> m_head{0};     // written by producer
+    std::atomic<quint32> m_tail{0};     // written by consumer
+    std::atomic<quint64> m_dropped{0};
+};
+
+// Asynchronous structured logger. Hot paths only fill a LogRecord into the
+// calling thread's ring, a background thread formats and writes them out.
+class Logger
+{
+public:
+    enum Level { Trace, Debug, Info, Warning, Error, Off };
+
+    static Logger *instance();
+
+    void setLevel(Level level);
+    Level level() const;
+    bool isEnabled(Level level) const { return level >= m_level.load(std::memory_order_relaxed); }
+
+    bool setOutputFile(const QString &path);
+    void flush();
+    quint64 dropped() const;
+
+    template <typename... Args>
+    void log(Level level, const char *format, const Args &... args)
+    {
+        LogRecord record;
+        record.level = static_cast<quint8>(level);
+        record.format = format;
+        record.argCount = 0;
+        record.textUsed = 0;
+        record.timestampUs = now();
+        setArgs(record, args...);
+        submit(record);
+    }
+
+    static Level levelFromString(const QString &name);
+
+private:
+    Logger();
+    ~Logger();
+    Q_DISABLE_COPY(Logger)
+
+    static void setArgs(LogRecord &) {}
+
+    template <typename T, typename... Rest>
+    static void setArgs(LogRecord &record, const T &arg, const Rest &... rest)
+    {
+        if (record.argCount < LogRecord::MaxArgs)
+            setArg(record, arg);
+        setArgs(record, rest...);
+    }
+
+    static void setArg(LogRecord &record, int value);
+    static void setArg(LogRecord &record, uint value);
+    static void setArg(LogRecord &record, long value);
+    static void setArg(LogRecord &record, unsigned long value);
+    static void setArg(LogRecord &record, qint64 value);
+    static void setArg(LogRecord &record, quint64 value);
+    static void setArg(LogRecord &record, double value);
+    static void setArg(LogRecord &record, bool value);
+    static void setArg(LogRecord &record, const char *literal);
+    static void setArg(LogRecord &record, const QString &text);
+    static void setArg(LogRecord &record, const QByteArray &bytes);       // logged as hex
+    static void setText(LogRecord &record, const char *data, int size, bool hex);
+    static void finishText(LogRecord &record, int offset, int written);
+
+    static qint64 now();
+
+    void submit(const LogRecord &record);
+    LogRing *threadRing();
+    // Thread exit, the ring's records are written out before it goes
+    void releaseRing(LogRing *ring);
+    friend struct LogRingHolder;
+    void run();
+    int drain();
+    void write(const LogRecord &record);
+
+    std::atomic<int> m_level;
+    std::atomic<bool> m_running;
+
+    QMutex m_ringsMutex;
+    QList<LogRing *> m_rings;           // one per live logging thread
+    quint64 m_releasedDropped = 0;      // drops of the rings of finished threads
+
+    QMutex m_outputMutex;
+    FILE *m_output;
+
+    std::thread m_thread;
+};
+
+#endif // LOGGER_H
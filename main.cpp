@@ -1,12 +1,79 @@
 #include <QCoreApplication>
 
 #include <captogloveapi.h>
+#include "sessionanalyzer.h"
+#include "frameexporter.h"
+#include "benchmarks.h"
+#include "selfcheck.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#ifdef CAPTOGLOVE_ALLOC_CHECK
+#include "allocationcheck.h"
+#endif
 
 
 int main(int argc, char *argv[]){
     QCoreApplication a(argc, argv);
 
+    // Offline: captogloveapi --analyze <dir> [--out summary.csv] [--threads n]
+    const QStringList args = a.arguments();
+    const int analyze = args.indexOf("--analyze");
+    if (analyze > 0 && analyze + 1 < args.size()) {
+        SessionAnalyzer::Options options;
+        options.directory = args.at(analyze + 1);
+        options.configPath = QString("%1/%2").arg(PROJECT_PATH).arg("config.ini");
+        const int out = args.indexOf("--out");
+        if (out > 0 && out + 1 < args.size())
+            options.output = args.at(out + 1);
+        const int threads = args.indexOf("--threads");
+        if (threads > 0 && threads + 1 < args.size())
+            options.threads = args.at(threads + 1).toInt();
+        return SessionAnalyzer::run(options);
+    }
+
+    // Offline: captogloveapi --export-arrow <recording or dir>, writes .arrow files next to the recordings
+    const int exportArrow = args.indexOf("--export-arrow");
+    if (exportArrow > 0 && exportArrow + 1 < args.size()) {
+        HandModel model;
+        SessionAnalyzer::configureModel(model, QString("%1/%2").arg(PROJECT_PATH).arg("config.ini"));
+
+        const QFileInfo input(args.at(exportArrow + 1));
+        QStringList recordings;
+        if (input.isDir()) {
+            for (const QString &file : QDir(input.filePath()).entryList(QStringList() << "*.cgrec", QDir::Files, QDir::Name))
+                recordings.append(QDir(input.filePath()).filePath(file));
+        } else {
+            recordings.append(input.filePath());
+        }
+
+        int failed = 0;
+        for (const QString &recording : recordings) {
+            const QFileInfo info(recording);
+            if (!FrameExporter::exportRecording(recording, info.dir().filePath(info.completeBaseName() + ".arrow"), model))
+                failed++;
+        }
+        return failed > 0 ? 1 : 0;
+    }
+
+    // Offline: captogloveapi --bench <name> [samples]
+    const int bench = args.indexOf("--bench");
+    if (bench > 0 && bench + 1 < args.size())
+        return Benchmarks::run(args.at(bench + 1), bench + 2 < args.size() ? args.at(bench + 2).toInt() : 0);
+
+    // Offline: captogloveapi --self-check [name]
+    const int selfCheck = args.indexOf("--self-check");
+    if (selfCheck > 0)
+        return SelfCheck::run(selfCheck + 1 < args.size() ? args.at(selfCheck + 1) : QString());
+
     CaptoGloveAPI *ctrl = new CaptoGloveAPI(NULL,"");
+
+#ifdef CAPTOGLOVE_ALLOC_CHECK
+    if (a.arguments().contains("--alloc-check"))
+        return AllocationCheck::run(ctrl, 5000);
+#endif
+
     ctrl->run();
 
     return a.exec();
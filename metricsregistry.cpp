@@ -0,0 +1,219 @@
+#include "metricsregistry.h"
+#include "logger.h"
+
+#include <QSaveFile>
+#include <QSet>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+
+// ############## HISTOGRAM ##############
+Histogram::Histogram(const QList<double> &bounds):
+    m_bucketCount(qMin(bounds.size(), static_cast<int>(MaxBuckets)))
+{
+    for (int i = 0; i < m_bucketCount; ++i)
+        m_bounds[i] = bounds.at(i);
+    for (int i = 0; i <= MaxBuckets; ++i)
+        m_buckets[i].store(0, std::memory_order_relaxed);
+}
+
+// ############## REGISTRY ##############
+MetricsRegistry::MetricsRegistry(QObject *parent):
+    QObject(parent)
+{
+    connect(&m_exportTimer, &QTimer::timeout, this, &MetricsRegistry::writeExportFile);
+}
+
+MetricsRegistry::~MetricsRegistry()
+{
+    for (const Metric &metric : m_metrics) {
+        delete metric.counter;
+        delete metric.gauge;
+        delete metric.histogram;
+    }
+}
+
+Counter *MetricsRegistry::counter(const QString &name, const QString &help, const QString &labels)
+{
+    Metric &metric = add(CounterType, name, help, labels);
+    metric.counter = new Counter;
+    return metric.counter;
+}
+
+Gauge *MetricsRegistry::gauge(const QString &name, const QString &help, const QString &labels)
+{
+    Metric &metric = add(GaugeType, name, help, labels);
+    metric.gauge = new Gauge;
+    return metric.gauge;
+}
+
+Histogram *MetricsRegistry::histogram(const QString &name, const QString &help, const QList<double> &bounds,
+                                      const QString &labels)
+{
+    Metric &metric = add(HistogramType, name, help, labels);
+    metric.histogram = new Histogram(bounds);
+    return metric.histogram;
+}
+
+void MetricsRegistry::addCollector(const std::function<void()> &collector)
+{
+    m_collectors.append(collector);
+}
+
+void MetricsRegistry::setCommonLabels(const QString &labels)
+{
+    m_commonLabels = labels;
+}
+
+QString MetricsRegistry::label(const QString &name, const QString &value)
+{
+    // Backslash first, the other escapes add backslashes of their own
+    QString escaped = value;
+    escaped.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+    return QString("%1=\"%2\"").arg(name, escaped);
+}
+
+MetricsRegistry::Metric &MetricsRegistry::add(Type type, const QString &name, const QString &help, const QString &labels)
+{
+    Metric metric;
+    metric.type = type;
+    metric.name = name;
+    metric.help = help;
+    metric.labels = labels;
+    m_metrics.append(metric);
+    return m_metrics.last();
+}
+
+QString MetricsRegistry::labelSet(const QString &labels, const QString &extra) const
+{
+    QStringList parts;
+    if (!m_commonLabels.isEmpty())
+        parts << m_commonLabels;
+    if (!labels.isEmpty())
+        parts << labels;
+    if (!extra.isEmpty())
+        parts << extra;
+
+    return parts.isEmpty() ? QString() : QString("{%1}").arg(parts.join(","));
+}
+
+QByteArray MetricsRegistry::exportText()
+{
+    for (const std::function<void()> &collector : m_collectors)
+        collector();
+
+    static const char *TypeNames[] = { "counter", "gauge", "histogram" };
+
+    QString text;
+    QSet<QString> described;
+    for (const Metric &metric : m_metrics) {
+        // Label variants share one HELP/TYPE header
+        if (!described.contains(metric.name)) {
+            described.insert(metric.name);
+            QString help = metric.help;
+            help.replace("\\", "\\\\").replace("\n", "\\n");
+            text += QString("# HELP %1 %2\n").arg(metric.name, help);
+            text += QString("# TYPE %1 %2\n").arg(metric.name, QString::fromLatin1(TypeNames[metric.type]));
+        }
+
+        switch (metric.type) {
+        case CounterType:
+            text += QString("%1%2 %3\n").arg(metric.name, labelSet(metric.labels),
+                                             QString::number(metric.counter->value()));
+            break;
+        case GaugeType:
+            text += QString("%1%2 %3\n").arg(metric.name, labelSet(metric.labels),
+                                             QString::number(metric.gauge->value(), 'g', 10));
+            break;
+        case HistogramType:
+        {
+            const Histogram *h = metric.histogram;
+            quint64 cumulative = 0;
+            for (int i = 0; i <= h->bucketCount(); ++i) {
+                cumulative += h->bucketValue(i);
+                const QString le = i < h->bucketCount() ? QString::number(h->bound(i), 'g', 10) : QString("+Inf");
+                text += QString("%1_bucket%2 %3\n").arg(metric.name, labelSet(metric.labels, label("le", le)),
+                                                        QString::number(cumulative));
+            }
+            // One arg() per line, a % in a label value is not a placeholder
+            text += QString("%1_sum%2 %3\n").arg(metric.name, labelSet(metric.labels), QString::number(h->sum(), 'g', 10));
+            text += QString("%1_count%2 %3\n").arg(metric.name, labelSet(metric.labels), QString::number(cumulative));
+            break;
+        }
+        }
+    }
+
+    return text.toUtf8();
+}
+
+// ############## EXPORT ##############
+bool MetricsRegistry::setExportFile(const QString &path, int intervalMs)
+{
+    m_exportTimer.stop();
+    m_exportPath = path;
+    if (path.isEmpty() || intervalMs <= 0)
+        return false;
+
+    m_exportTimer.start(intervalMs);
+    return true;
+}
+
+void MetricsRegistry::writeExportFile()
+{
+    // Replaced atomically, a scraper never sees a half written file
+    QSaveFile file(m_exportPath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(exportText()) < 0 || !file.commit())
+        LOG_WARNING("Can't write metrics to %1", m_exportPath);
+}
+
+bool MetricsRegistry::listen(quint16 port)
+{
+    if (!m_server) {
+        m_server = new QTcpServer(this);
+        connect(m_server, &QTcpServer::newConnection, this, &MetricsRegistry::acceptConnection);
+    }
+
+    if (!m_server->listen(QHostAddress::LocalHost, port)) {
+        LOG_WARNING("Can't serve metrics on port %1: %2", static_cast<int>(port), m_server->errorString());
+        return false;
+    }
+
+    LOG_INFO("Serving metrics on port %1", static_cast<int>(port));
+    return true;
+}
+
+void MetricsRegistry::acceptConnection()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+
+        // Every request is answered with the full scrape once its headers are complete,
+        // the path is not looked at
+        QByteArray request;
+        bool answered = false;
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket, request, answered]() mutable {
+            if (answered) {
+                socket->readAll();
+                return;
+            }
+            request.append(socket->readAll());
+            if (!request.contains("\r\n\r\n")) {
+                if (request.size() > MaxRequestSize)
+                    socket->abort();
+                return;
+            }
+            answered = true;
+            request.clear();
+            const QByteArray body = exportText();
+            QByteArray header("HTTP/1.0 200 OK\r\n"
+                              "Content-Type: text/plain; version=0.0.4\r\n"
+                              "Connection: close\r\n"
+                              "Content-Length: ");
+            header.append(QByteArray::number(body.size()));
+            header.append("\r\n\r\n");
+            socket->write(header);
+            socket->write(body);
+            socket->disconnectFromHost();
+        });
+    }
+}
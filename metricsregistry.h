@@ -0,0 +1,126 @@
+#ifndef METRICSREGISTRY_H
+#define METRICSREGISTRY_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QTimer>
+
+#include <atomic>
+#include <functional>
+
+class QTcpServer;
+
+// Hot path updates below are single relaxed atomic operations
+
+class Counter
+{
+public:
+    void increment(quint64 n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    quint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<quint64> m_value{0};
+};
+
+class Gauge
+{
+public:
+    void set(double value) { m_value.store(value, std::memory_order_relaxed); }
+    double value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> m_value{0.0};
+};
+
+class Histogram
+{
+public:
+    static const int MaxBuckets = 16;
+
+    explicit Histogram(const QList<double> &bounds);
+
+    void observe(double value)
+    {
+        int bucket = 0;
+        while (bucket < m_bucketCount && value > m_bounds[bucket])
+            ++bucket;
+        m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+        double sum = m_sum.load(std::memory_order_relaxed);
+        while (!m_sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed)) {}
+    }
+
+    int bucketCount() const { return m_bucketCount; }
+    double bound(int bucket) const { return m_bounds[bucket]; }
+    quint64 bucketValue(int bucket) const { return m_buckets[bucket].load(std::memory_order_relaxed); }  // bucketCount() is +Inf
+    double sum() const { return m_sum.load(std::memory_order_relaxed); }
+
+private:
+    int m_bucketCount;
+    double m_bounds[MaxBuckets];
+    std::atomic<quint64> m_buckets[MaxBuckets + 1];
+    std::atomic<double> m_sum{0.0};
+};
+
+// Owns all metrics of one glove and exports them in Prometheus text format,
+// to a file on a scrape interval and/or on a local HTTP port
+class MetricsRegistry : public QObject
+{
+    Q_OBJECT
+public:
+    MetricsRegistry(QObject *parent = nullptr);
+    ~MetricsRegistry();
+
+    // labels in Prometheus syntax, f.e. characteristic="finger", build them with label()
+    Counter *counter(const QString &name, const QString &help, const QString &labels = QString());
+    Gauge *gauge(const QString &name, const QString &help, const QString &labels = QString());
+    Histogram *histogram(const QString &name, const QString &help, const QList<double> &bounds,
+                         const QString &labels = QString());
+
+    // Called before every export, f.e. to sample gauges from cold getters
+    void addCollector(const std::function<void()> &collector);
+    void setCommonLabels(const QString &labels);
+
+    // name="value", backslash, quote and newline of value escaped as the text format requires
+    static QString label(const QString &name, const QString &value);
+
+    QByteArray exportText();
+
+    bool setExportFile(const QString &path, int intervalMs);
+    bool listen(quint16 port);
+
+private slots:
+    void writeExportFile();
+    void acceptConnection();
+
+private:
+    // Requests whose headers don't end within this many bytes are dropped
+    static const int MaxRequestSize = 8192;
+
+    enum Type { CounterType, GaugeType, HistogramType };
+
+    struct Metric {
+        Type type;
+        QString name;
+        QString help;
+        QString labels;
+        Counter *counter = nullptr;
+        Gauge *gauge = nullptr;
+        Histogram *histogram = nullptr;
+    };
+
+    Metric &add(Type type, const QString &name, const QString &help, const QString &labels);
+    QString labelSet(const QString &labels, const QString &extra = QString()) const;
+
+    QList<Metric> m_metrics;
+    QList<std::function<void()>> m_collectors;
+    QString m_commonLabels;
+
+    QString m_exportPath;
+    QTimer m_exportTimer;
+    QTcpServer *m_server = nullptr;
+};
+
+#endif // METRICSREGISTRY_H
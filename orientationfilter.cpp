@@ -0,0 +1,122 @@
+#include "orientationfilter.h"
+
+#include <cmath>
+
+namespace {
+// Samples further apart than this are not integrated, a stale rate would wind the orientation up
+const float MaxStepSeconds = 0.5f;
+}
+
+int decodeImuPayload(const uchar *data, int size, float accelScale, float gyroScale,
+                     qint64 previousUs, qint64 timestampUs, ImuSample *out, int maxOut)
+{
+    const int count = qMin(size / ImuLayout::size, maxOut);
+    if (count <= 0)
+        return 0;
+
+    const qint64 spanUs = previousUs > 0 ? timestampUs - previousUs : 0;
+    for (int i = 0; i < count; ++i) {
+        FingerFrame raw;
+        decodePayload<ImuLayout>(data + i * ImuLayout::size, ImuLayout::size, raw);
+
+        ImuSample &s = out[i];
+        s.timestampUs = timestampUs - spanUs * (count - 1 - i) / count;
+        for (int k = 0; k < 3; ++k) {
+            s.accel[k] = raw.channels[k] * accelScale;
+            s.gyro[k] = raw.channels[3 + k] * gyroScale;
+        }
+    }
+
+    return count;
+}
+
+OrientationFilter::OrientationFilter():
+    m_beta(0.1f)
+{
+    reset();
+}
+
+void OrientationFilter::setBeta(float beta)
+{
+    m_beta = beta;
+}
+
+void OrientationFilter::reset()
+{
+    m_q[0] = 1.0f;
+    m_q[1] = 0.0f;
+    m_q[2] = 0.0f;
+    m_q[3] = 0.0f;
+    m_lastUs = 0;
+}
+
+void OrientationFilter::update(const ImuSample &sample)
+{
+    const float dt = m_lastUs > 0 ? (sample.timestampUs - m_lastUs) * 1e-6f : 0.0f;
+    m_lastUs = sample.timestampUs;
+
+    if (dt > 0.0f && dt < MaxStepSeconds)
+        integrate(sample, dt);
+}
+
+void OrientationFilter::update(const ImuSample *samples, int count)
+{
+    // Each queued sample is integrated over its own interval
+    for (int i = 0; i < count; ++i)
+        update(samples[i]);
+}
+
+const float *OrientationFilter::quaternion() const
+{
+    return m_q;
+}
+
+void OrientationFilter::integrate(const ImuSample &sample, float dt)
+{
+    float q0 = m_q[0], q1 = m_q[1], q2 = m_q[2], q3 = m_q[3];
+    const float gx = sample.gyro[0], gy = sample.gyro[1], gz = sample.gyro[2];
+    float ax = sample.accel[0], ay = sample.accel[1], az = sample.accel[2];
+
+    // Rate of change from the gyroscope
+    float qDot0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qDot1 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qDot2 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qDot3 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    // Gradient descent correction towards gravity, skipped in free fall
+    const float aNorm = std::sqrt(ax * ax + ay * ay + az * az);
+    if (aNorm > 0.0f) {
+        ax /= aNorm;
+        ay /= aNorm;
+        az /= aNorm;
+
+        const float _2q0 = 2.0f * q0, _2q1 = 2.0f * q1, _2q2 = 2.0f * q2, _2q3 = 2.0f * q3;
+        const float _4q0 = 4.0f * q0, _4q1 = 4.0f * q1, _4q2 = 4.0f * q2;
+        const float _8q1 = 8.0f * q1, _8q2 = 8.0f * q2;
+        const float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+
+        float s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+        float s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+        float s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+        float s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+
+        const float sNorm = std::sqrt(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+        if (sNorm > 0.0f) {
+            qDot0 -= m_beta * s0 / sNorm;
+            qDot1 -= m_beta * s1 / sNorm;
+            qDot2 -= m_beta * s2 / sNorm;
+            qDot3 -= m_beta * s3 / sNorm;
+        }
+    }
+
+    q0 += qDot0 * dt;
+    q1 += qDot1 * dt;
+    q2 += qDot2 * dt;
+    q3 += qDot3 * dt;
+
+    const float qNorm = std::sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    m_q[0] = q0 / qNorm;
+    m_q[1] = q1 / qNorm;
+    m_q[2] = q2 / qNorm;
+    m_q[3] = q3 / qNorm;
+}
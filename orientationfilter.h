@@ -0,0 +1,48 @@
+#ifndef ORIENTATIONFILTER_H
+#define ORIENTATIONFILTER_H
+
+#include <QtGlobal>
+
+#include "payloadlayout.h"
+
+// One inertial reading, accelerometer in g and gyroscope in rad/s
+struct ImuSample
+{
+    qint64 timestampUs = 0;
+    float accel[3] = {};
+    float gyro[3] = {};
+};
+
+// Raw IMU record: accelerometer xyz then gyroscope xyz, signed 16 bit little endian
+typedef PayloadLayout<6, 2, ByteOrder::LittleEndian, true> ImuLayout;
+
+// Decodes all records packed into one notification. Timestamps are spread
+// evenly between the previous notification and this one.
+int decodeImuPayload(const uchar *data, int size, float accelScale, float gyroScale,
+                     qint64 previousUs, qint64 timestampUs, ImuSample *out, int maxOut);
+
+// Madgwick gradient descent orientation filter without magnetometer.
+// Runs in constant time and never allocates.
+class OrientationFilter
+{
+public:
+    OrientationFilter();
+
+    void setBeta(float beta);
+    void reset();
+
+    void update(const ImuSample &sample);
+    void update(const ImuSample *samples, int count);
+
+    // w, x, y, z
+    const float *quaternion() const;
+
+private:
+    void integrate(const ImuSample &sample, float dt);
+
+    float m_beta;
+    float m_q[4];
+    qint64 m_lastUs;
+};
+
+#endif // ORIENTATIONFILTER_H
@@ -0,0 +1,46 @@
+#include "payloadlayout.h"
+
+namespace {
+
+// One byte per sensor, current CaptoGlove firmware (indices 0-5)
+typedef PayloadLayout<6, 1, ByteOrder::LittleEndian> U8x6;
+typedef PayloadLayout<10, 1, ByteOrder::LittleEndian> U8x10;
+typedef PayloadLayout<5, 2, ByteOrder::LittleEndian> U16LEx5;
+typedef PayloadLayout<10, 2, ByteOrder::LittleEndian> U16LEx10;
+typedef PayloadLayout<5, 2, ByteOrder::BigEndian> U16BEx5;
+// 12 bit sensors in 16 bit words, scaled down to the 8 bit range
+typedef PayloadLayout<10, 2, ByteOrder::LittleEndian, false, 0, 1, 16> U12LEx10;
+
+template <class Layout>
+PayloadFormat format(const char *name)
+{
+    PayloadFormat f = { name, &decodePayload<Layout>, Layout::channels, Layout::size };
+    return f;
+}
+
+const PayloadFormat formats[] = {
+    format<U8x6>("u8x6"),
+    format<U8x10>("u8x10"),
+    format<U16LEx5>("u16lex5"),
+    format<U16LEx10>("u16lex10"),
+    format<U16BEx5>("u16bex5"),
+    format<U12LEx10>("u12lex10")
+};
+
+}
+
+const PayloadFormat &PayloadFormats::defaultFormat()
+{
+    return formats[0];
+}
+
+const PayloadFormat *PayloadFormats::find(const QString &name)
+{
+    const QString wanted = name.trimmed().toLower();
+    for (const PayloadFormat &f : formats) {
+        if (wanted == QLatin1String(f.name))
+            return &f;
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,114 @@
+#ifndef PAYLOADLAYOUT_H
+#define PAYLOADLAYOUT_H
+
+#include <QtGlobal>
+#include <QString>
+
+#include "fingerframe.h"
+
+enum class ByteOrder { LittleEndian, BigEndian };
+
+// Compile time description of a finger position payload. Every layout gets
+// its own fully unrolled decoder, see decodePayload().
+template <int Channels, int Width, ByteOrder Order, bool Signed = false,
+          int HeaderBytes = 0, int ScaleNum = 1, int ScaleDen = 1>
+struct PayloadLayout
+{
+    static_assert(Channels > 0 && Channels <= FingerFrame::MaxChannels, "Too many channels for FingerFrame");
+    static_assert(Width >= 1 && Width <= 4, "Channel width must be 1 to 4 bytes");
+    static_assert(ScaleDen != 0, "Scale denominator can't be zero");
+
+    static const int channels = Channels;
+    static const int width = Width;
+    static const ByteOrder order = Order;
+    static const bool isSigned = Signed;
+    static const int headerBytes = HeaderBytes;
+    static const int size = HeaderBytes + Channels * Width;
+
+    static constexpr float scale() { return static_cast<float>(ScaleNum) / static_cast<float>(ScaleDen); }
+};
+
+namespace PayloadDecoding
+{
+
+// Assembles one channel byte by byte
+template <int Width, ByteOrder Order, int Byte = 0>
+struct RawReader
+{
+    static quint32 read(const uchar *p)
+    {
+        return (static_cast<quint32>(p[Order == ByteOrder::LittleEndian ? Byte : Width - 1 - Byte]) << (8 * Byte))
+                | RawReader<Width, Order, Byte + 1>::read(p);
+    }
+};
+
+template <int Width, ByteOrder Order>
+struct RawReader<Width, Order, Width>
+{
+    static quint32 read(const uchar *) { return 0; }
+};
+
+template <int Width, bool Signed>
+struct Extend
+{
+    static float apply(quint32 raw) { return static_cast<float>(raw); }
+};
+
+template <int Width>
+struct Extend<Width, true>
+{
+    static float apply(quint32 raw)
+    {
+        return static_cast<float>(static_cast<qint32>(raw << (32 - 8 * Width)) >> (32 - 8 * Width));
+    }
+};
+
+template <class Layout, int Channel, int Remaining>
+struct ChannelUnroll
+{
+    static void decode(const uchar *data, float *out)
+    {
+        const quint32 raw = RawReader<Layout::width, Layout::order>::read(data + Layout::headerBytes + Channel * Layout::width);
+        out[Channel] = Extend<Layout::width, Layout::isSigned>::apply(raw) * Layout::scale();
+        ChannelUnroll<Layout, Channel + 1, Remaining - 1>::decode(data, out);
+    }
+};
+
+template <class Layout, int Channel>
+struct ChannelUnroll<Layout, Channel, 0>
+{
+    static void decode(const uchar *, float *) {}
+};
+
+}
+
+// Decodes one payload into frame channels, false if the payload is too short
+template <class Layout>
+bool decodePayload(const uchar *data, int size, FingerFrame &frame)
+{
+    if (size < Layout::size)
+        return false;
+
+    PayloadDecoding::ChannelUnroll<Layout, 0, Layout::channels>::decode(data, frame.channels);
+    frame.channelCount = Layout::channels;
+    return true;
+}
+
+typedef bool (*PayloadDecoder)(const uchar *data, int size, FingerFrame &frame);
+
+// Named layout, selected at connect time from the reported glove model
+struct PayloadFormat
+{
+    const char *name;
+    PayloadDecoder decode;
+    int channels;
+    int size;
+};
+
+namespace PayloadFormats
+{
+const PayloadFormat &defaultFormat();
+const PayloadFormat *find(const QString &name);
+}
+
+#endif // PAYLOADLAYOUT_H
@@ -0,0 +1,185 @@
+#include "selfcheck.h"
+#include "writequeue.h"
+#include "characteristicregistry.h"
+#include "listingsnapshot.h"
+#include "captogloveuuids.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QStringList>
+
+#include <cstdio>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace {
+
+int g_failures = 0;
+
+const int ReconnectCharacteristics = 24;
+const int ReconnectWarmup = 100;
+const int ReconnectCycles = 20000;
+// Allocator noise allowed over all cycles, a leak of one record per cycle is far above it
+const qint64 ReconnectMaxGrowth = 512 * 1024;
+
+void check(bool condition, const char *what)
+{
+    if (condition)
+        return;
+
+    g_failures++;
+    fprintf(stderr, "  FAILED: %s\n", what);
+}
+
+// Resident set in bytes, 0 where /proc isn't available
+qint64 residentBytes()
+{
+#ifdef Q_OS_LINUX
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 1)
+            return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+    }
+#endif
+    return 0;
+}
+
+// Characteristics of one connection as service discovery reports them
+void discover(CharacteristicRegistry &registry, int connection)
+{
+    const QBluetoothUuid services[] = { CaptoGloveUuids::fingerPositionService(),
+                                        QBluetoothUuid(QBluetoothUuid::BatteryService),
+                                        QBluetoothUuid(QBluetoothUuid::DeviceInformation) };
+    for (int i = 0; i < ReconnectCharacteristics; ++i) {
+        CharacteristicRecord record;
+        record.handle = static_cast<QLowEnergyHandle>(0x10 + 3 * i);
+        record.service = services[i % 3];
+        record.uuid = QBluetoothUuid(static_cast<quint16>(0x2a00 + i));
+        record.properties = QLowEnergyCharacteristic::Read | QLowEnergyCharacteristic::Notify;
+        record.name = QString("Characteristic %1").arg(i);
+        record.value = QByteArray::number(connection);
+        registry.add(record);
+    }
+}
+
+QList<QByteArray> values(const WriteQueue &queue, const QBluetoothUuid &characteristic)
+{
+    QList<QByteArray> result;
+    for (const QPair<QBluetoothUuid, QByteArray> &command : queue.pending()) {
+        if (command.first == characteristic)
+            result.append(command.second);
+    }
+    return result;
+}
+
+}
+
+int SelfCheck::writeQueueOrder()
+{
+    const int before = g_failures;
+    const QBluetoothUuid command = CaptoGloveUuids::fingerCommand();
+    const QBluetoothUuid setting = CaptoGloveUuids::fingerF002();
+
+    // Without a service nothing is sent, the queue shows what would go out
+    WriteQueue queue;
+    queue.enqueue(command, QByteArray("83"));
+    queue.enqueue(command, QByteArray("01"));
+    queue.enqueue(command, QByteArray("83"));
+    check(values(queue, command) == (QList<QByteArray>() << "83" << "01" << "83"),
+          "distinct commands to one characteristic are sent in enqueue order");
+
+    queue.enqueue(command, QByteArray("83"));
+    check(queue.pending().size() == 3, "a repeat of the last queued command is merged");
+
+    queue.enqueue(setting, QByteArray("10"), true);
+    queue.enqueue(command, QByteArray("02"));
+    queue.enqueue(setting, QByteArray("20"), true);
+    check(queue.pending().size() == 5, "an idempotent write replaces the queued one");
+    check(queue.pending().at(3).second == QByteArray("20"), "the replaced idempotent write keeps its place");
+
+    queue.enqueue(setting, QByteArray("30"));
+    check(values(queue, setting) == (QList<QByteArray>() << "20" << "30"),
+          "a non idempotent write queues behind an idempotent one");
+
+    queue.enqueue(command, QByteArray("01"));
+    check(values(queue, command) == (QList<QByteArray>() << "83" << "01" << "83" << "02" << "01"),
+          "a value equal to an older, not last, command is queued again");
+
+    check(queue.stats().coalesced == 2, "merges are counted");
+    return g_failures - before;
+}
+
+int SelfCheck::reconnectSoak()
+{
+    const int before = g_failures;
+    CharacteristicRegistry registry;
+    ListingModel listing;
+
+    int capacity = 0;
+    qint64 resident = 0;
+    bool sizeHeld = true;
+    bool capacityHeld = true;
+    for (int cycle = 0; cycle < ReconnectWarmup + ReconnectCycles; ++cycle) {
+        // Same sequence as releaseServices() and the discovery handlers, rediscovery included
+        registry.recycle();
+        discover(registry, cycle);
+        discover(registry, cycle);
+        sizeHeld &= registry.size() == ReconnectCharacteristics;
+
+        const QVector<CharacteristicRecord> records = registry.records();
+        QVector<ListingRow> rows;
+        rows.reserve(records.size());
+        for (const CharacteristicRecord &record : records)
+            rows.append(ListingRow::characteristic(record));
+        listing.publish(rows);
+
+        if (cycle == ReconnectWarmup - 1) {
+            capacity = registry.capacity();
+            resident = residentBytes();
+        } else if (cycle >= ReconnectWarmup) {
+            capacityHeld &= registry.capacity() == capacity;
+        }
+    }
+
+    const qint64 growth = residentBytes() - resident;
+    check(sizeHeld, "every connection holds exactly its characteristics");
+    check(capacityHeld, "registry storage is reused across reconnects");
+    check(growth < ReconnectMaxGrowth, "resident memory stays flat over the reconnects");
+    check(listing.snapshot()->rows.size() == ReconnectCharacteristics, "the listing shows one connection");
+    fprintf(stderr, "  %d reconnects, registry capacity %d, resident growth %lld bytes\n",
+            ReconnectCycles, capacity, static_cast<long long>(growth));
+    return g_failures - before;
+}
+
+int SelfCheck::run(const QString &name)
+{
+    struct Entry { const char *name; int (*check)(); };
+    const Entry checks[] = {
+        { "writequeue", &writeQueueOrder },
+        { "reconnect", &reconnectSoak }
+    };
+
+    QStringList known;
+    bool ran = false;
+    g_failures = 0;
+    for (const Entry &entry : checks) {
+        known << QString::fromLatin1(entry.name);
+        if (!name.isEmpty() && name != known.last())
+            continue;
+
+        ran = true;
+        const int failed = entry.check();
+        fprintf(stderr, "%-12s %s\n", entry.name, failed == 0 ? "passed" : "FAILED");
+    }
+
+    if (!ran) {
+        fprintf(stderr, "Unknown check %s, one of: %s\n", qPrintable(name), qPrintable(known.join(", ")));
+        return 1;
+    }
+
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+#ifndef SELFCHECK_H
+#define SELFCHECK_H
+
+#include <QString>
+
+// Behaviour checks that need no glove, run with --self-check [name].
+// Failures go to stderr, the return value is the process exit code.
+namespace SelfCheck {
+
+// Distinct commands keep their order, only repeats and idempotent writes merge
+int writeQueueOrder();
+// Many reconnects fill the characteristic registry and listing without growing memory
+int reconnectSoak();
+
+// All checks when name is empty
+int run(const QString &name);
+
+}
+
+#endif // SELFCHECK_H
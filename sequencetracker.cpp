@@ -0,0 +1,240 @@
+#include "sequencetracker.h"
+
+#include <cstring>
+
+namespace {
+// Intervals longer than this many expected periods are treated as gaps, not learned
+const double GapFactor = 1.5;
+// Weight of the newest interval in the running average
+const double IntervalAlpha = 0.05;
+}
+
+double SequenceTracker::Stats::lossRate() const
+{
+    const quint64 expected = received + lost;
+    if (expected == 0)
+        return 0.0;
+
+    return static_cast<double>(lost) / static_cast<double>(expected);
+}
+
+SequenceTracker::SequenceTracker():
+    m_counterOffset(-1),
+    m_counterWidth(1),
+    m_fillPolicy(FillNone),
+    m_maxFill(8)
+{
+    reset();
+}
+
+void SequenceTracker::setCounter(int offset, int width)
+{
+    m_counterOffset = offset;
+    m_counterWidth = qBound(1, width, 4);
+}
+
+void SequenceTracker::setFillPolicy(FillPolicy policy)
+{
+    m_fillPolicy = policy;
+}
+
+void SequenceTracker::setMaxFill(int maxFill)
+{
+    m_maxFill = qMax(0, maxFill);
+}
+
+SequenceTracker::FillPolicy SequenceTracker::fillPolicy() const
+{
+    return m_fillPolicy;
+}
+
+int SequenceTracker::counterOffset() const
+{
+    return m_counterOffset;
+}
+
+int SequenceTracker::counterWidth() const
+{
+    return m_counterWidth;
+}
+
+const uchar *SequenceTracker::channelData(const uchar *payload, int &size, uchar *scratch) const
+{
+    if (m_counterOffset < 0 || m_counterOffset >= size)
+        return payload;
+
+    // Layouts are far shorter than the ATT limit, bytes past it are never decoded
+    size = qMin(size, static_cast<int>(MaxPayload));
+    const int end = m_counterOffset + m_counterWidth;
+    if (m_counterOffset == 0) {
+        size = qMax(0, size - m_counterWidth);
+        return payload + m_counterWidth;
+    }
+    if (end >= size) {
+        size = m_counterOffset;
+        return payload;
+    }
+
+    memcpy(scratch, payload, static_cast<size_t>(m_counterOffset));
+    memcpy(scratch + m_counterOffset, payload + end, static_cast<size_t>(size - end));
+    size -= m_counterWidth;
+    return scratch;
+}
+
+void SequenceTracker::reset()
+{
+    m_hasPrevious = false;
+    m_lastCounter = 0;
+    m_sequence = 0;
+    m_intervalUs = 0;
+    m_previous = FingerFrame();
+    m_beforeGap = FingerFrame();
+    m_stats = Stats();
+}
+
+void SequenceTracker::handover()
+{
+    if (m_hasPrevious)
+        m_sequence++;
+    m_hasPrevious = false;
+    m_lastCounter = 0;
+    m_intervalUs = 0;
+    m_previous = FingerFrame();
+    m_beforeGap = FingerFrame();
+}
+
+int SequenceTracker::track(const uchar *payload, int size, FingerFrame &frame)
+{
+    const bool counted = m_counterOffset >= 0 && m_counterOffset + m_counterWidth <= size;
+
+    int missing = 0;
+    if (counted)
+        missing = trackCounter(payload);
+    else if (m_hasPrevious)
+        missing = trackTiming(frame);
+
+    if (missing < 0) {
+        frame.sequence = m_sequence;
+        frame.flags |= FingerFrame::Duplicate;
+        m_stats.duplicates++;
+        return -1;
+    }
+
+    if (m_hasPrevious) {
+        const qint64 delta = frame.timestampUs - m_previous.timestampUs;
+        if (missing == 0 && delta > 0) {
+            if (m_intervalUs == 0)
+                m_intervalUs = delta;
+            else
+                m_intervalUs += static_cast<qint64>((delta - m_intervalUs) * IntervalAlpha);
+        }
+        m_sequence += static_cast<quint64>(missing) + 1;
+    }
+
+    if (missing > 0) {
+        frame.flags |= FingerFrame::GapBefore;
+        m_stats.lost += static_cast<quint64>(missing);
+        m_stats.gaps++;
+    }
+
+    frame.sequence = m_sequence;
+    m_stats.received++;
+
+    m_beforeGap = m_previous;
+    m_previous = frame;
+    m_hasPrevious = true;
+
+    return missing;
+}
+
+int SequenceTracker::fill(const FingerFrame &frame, int missing, FingerFrame *out, int maxOut)
+{
+    if (m_fillPolicy == FillNone || missing <= 0)
+        return 0;
+
+    const FingerFrame &last = m_beforeGap;
+    const int count = qMin(qMin(missing, m_maxFill), maxOut);
+    const int channels = qMin(last.channelCount, frame.channelCount);
+    for (int i = 0; i < count; ++i) {
+        FingerFrame &f = out[i];
+        const float t = static_cast<float>(i + 1) / static_cast<float>(missing + 1);
+
+        f = last;
+        f.sequence = frame.sequence - static_cast<quint64>(missing - i);
+        f.timestampUs = last.timestampUs + static_cast<qint64>((frame.timestampUs - last.timestampUs) * t);
+        f.flags = FingerFrame::Filled;
+
+        if (m_fillPolicy == FillLinear) {
+            for (int ch = 0; ch < channels; ++ch)
+                f.channels[ch] = last.channels[ch] + (frame.channels[ch] - last.channels[ch]) * t;
+        }
+    }
+
+    m_stats.filled += static_cast<quint64>(count);
+    return count;
+}
+
+SequenceTracker::Stats SequenceTracker::stats() const
+{
+    return m_stats;
+}
+
+qint64 SequenceTracker::expectedIntervalUs() const
+{
+    return m_intervalUs;
+}
+
+SequenceTracker::FillPolicy SequenceTracker::fillPolicyFromString(const QString &name)
+{
+    const QString policy = name.toLower();
+    if (policy == "hold")
+        return FillHold;
+    if (policy == "linear")
+        return FillLinear;
+
+    return FillNone;
+}
+
+int SequenceTracker::trackCounter(const uchar *payload)
+{
+    quint32 counter = 0;
+    for (int i = 0; i < m_counterWidth; ++i)
+        counter |= static_cast<quint32>(payload[m_counterOffset + i]) << (8 * i);
+
+    if (!m_hasPrevious) {
+        m_lastCounter = counter;
+        return 0;
+    }
+
+    const quint64 range = Q_UINT64_C(1) << (8 * m_counterWidth);
+    const quint64 diff = (static_cast<quint64>(counter) + range - m_lastCounter) % range;
+
+    // Zero or backwards steps are re-deliveries of samples we already have
+    if (diff == 0 || diff > range / 2)
+        return -1;
+
+    m_lastCounter = counter;
+    return static_cast<int>(diff - 1);
+}
+
+int SequenceTracker::trackTiming(const FingerFrame &frame) const
+{
+    if (m_intervalUs <= 0)
+        return 0;
+
+    const qint64 delta = frame.timestampUs - m_previous.timestampUs;
+
+    // Same sample right on top of the previous one -> duplicate delivery
+    if (delta < m_intervalUs / 4 && frame.channelCount == m_previous.channelCount) {
+        bool same = true;
+        for (int i = 0; i < frame.channelCount && same; ++i)
+            same = frame.channels[i] == m_previous.channels[i];
+        if (same)
+            return -1;
+    }
+
+    if (delta <= static_cast<qint64>(m_intervalUs * GapFactor))
+        return 0;
+
+    return qMax(0, static_cast<int>((delta + m_intervalUs / 2) / m_intervalUs) - 1);
+}
@@ -0,0 +1,80 @@
+#ifndef SEQUENCETRACKER_H
+#define SEQUENCETRACKER_H
+
+#include <QtGlobal>
+#include <QString>
+
+#include "fingerframe.h"
+
+// Assigns sequence numbers to incoming finger frames and detects lost or
+// duplicated notifications. Uses a payload counter when the firmware provides
+// one (see setCounter), otherwise learns the notification interval and
+// derives losses from arrival timing.
+class SequenceTracker
+{
+public:
+    enum FillPolicy {
+        FillNone,       // only flag the gap
+        FillHold,       // repeat the last received sample
+        FillLinear      // interpolate between the samples around the gap
+    };
+
+    struct Stats {
+        quint64 received = 0;
+        quint64 lost = 0;
+        quint64 duplicates = 0;
+        quint64 gaps = 0;
+        quint64 filled = 0;
+
+        double lossRate() const;
+    };
+
+    SequenceTracker();
+
+    void setCounter(int offset, int width);                 // offset < 0 -> timing based
+    void setFillPolicy(FillPolicy policy);
+    void setMaxFill(int maxFill);
+    FillPolicy fillPolicy() const;
+    int counterOffset() const;
+    int counterWidth() const;
+    // Largest payload channelData() cuts the counter out of, the ATT value limit
+    static const int MaxPayload = 512;
+    // Payload without the counter bytes, wherever they sit. Points into payload when the
+    // counter leads or trails it, else into scratch (MaxPayload bytes). size is updated
+    const uchar *channelData(const uchar *payload, int &size, uchar *scratch) const;
+
+    void reset();
+    // Next frame comes from another glove: counter and interval are learned again, sequence numbers go on
+    void handover();
+
+    // Returns number of samples lost right before frame, or -1 if it is a duplicate
+    int track(const uchar *payload, int size, FingerFrame &frame);
+
+    // Writes up to maxOut synthesized frames for the gap track() reported before frame
+    int fill(const FingerFrame &frame, int missing, FingerFrame *out, int maxOut);
+
+    Stats stats() const;
+    qint64 expectedIntervalUs() const;
+
+    static FillPolicy fillPolicyFromString(const QString &name);
+
+private:
+    int trackCounter(const uchar *payload);
+    int trackTiming(const FingerFrame &frame) const;
+
+    int m_counterOffset;
+    int m_counterWidth;
+    FillPolicy m_fillPolicy;
+    int m_maxFill;
+
+    bool m_hasPrevious;
+    quint32 m_lastCounter;
+    quint64 m_sequence;
+    qint64 m_intervalUs;                                    // learned notification interval
+    FingerFrame m_previous;
+    FingerFrame m_beforeGap;                                // last frame received before m_previous
+
+    Stats m_stats;
+};
+
+#endif // SEQUENCETRACKER_H
@@ -1,22 +1,46 @@
 #include "serviceinfo.h"
 
 ServiceInfo::ServiceInfo(QLowEnergyService *service):
-    m_service(service)
+    m_service(service),
+    m_uuid(service->serviceUuid())
 {
     m_service->setParent(this);
 }
 
+ServiceInfo::ServiceInfo(const QBluetoothUuid &uuid):
+    m_uuid(uuid)
+{
+}
+
 QLowEnergyService *ServiceInfo::service() const
 {
     return m_service;
 }
 
+void ServiceInfo::setService(QLowEnergyService *service)
+{
+    m_service = service;
+    m_service->setParent(this);
+    emit serviceChanged();
+}
+
+QBluetoothUuid ServiceInfo::uuid() const
+{
+    return m_uuid;
+}
+
 QString ServiceInfo::getName() const
 {
-    if (!m_service)
-        return QString();
+    if (m_service)
+        return m_service->serviceName();
 
-    return m_service->serviceName();
+    // Same name the service object reports once it exists
+    bool success = false;
+    const quint16 uuid16 = m_uuid.toUInt16(&success);
+    if (success)
+        return QBluetoothUuid::serviceClassToString(static_cast<QBluetoothUuid::ServiceClassUuid>(uuid16));
+
+    return QStringLiteral("Unknown Service");
 }
 
 QString ServiceInfo::getType() const
@@ -40,18 +64,14 @@ QString ServiceInfo::getType() const
 
 QString ServiceInfo::getUuid() const
 {
-    if (!m_service)
-        return QString();
-
-    const QBluetoothUuid uuid = m_service->serviceUuid();
     bool success = false;
-    quint16 result16 = uuid.toUInt16(&success);
+    quint16 result16 = m_uuid.toUInt16(&success);
     if (success)
         return QStringLiteral("0x") + QString::number(result16, 16);
 
-    quint32 result32 = uuid.toUInt32(&success);
+    quint32 result32 = m_uuid.toUInt32(&success);
     if (success)
         return QStringLiteral("0x") + QString::number(result32, 16);
 
-    return uuid.toString().remove(QLatin1Char('{')).remove(QLatin1Char('}'));
+    return m_uuid.toString().remove(QLatin1Char('{')).remove(QLatin1Char('}'));
 }
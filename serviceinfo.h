@@ -11,7 +11,11 @@ class ServiceInfo: public QObject
 public:
     ServiceInfo() = default;
     ServiceInfo(QLowEnergyService *service);
+    // Advertised service, the service object is set when it is first opened
+    ServiceInfo(const QBluetoothUuid &uuid);
     QLowEnergyService *service() const;
+    void setService(QLowEnergyService *service);
+    QBluetoothUuid uuid() const;
     QString getUuid() const;
     QString getName() const;
     QString getType() const;
@@ -21,6 +25,7 @@ Q_SIGNALS:
 
 private:
     QLowEnergyService *m_service = nullptr;
+    QBluetoothUuid m_uuid;
 };
 
 #endif // SERVICEINFO_H
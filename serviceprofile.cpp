@@ -0,0 +1,85 @@
+#include "serviceprofile.h"
+#include "captogloveuuids.h"
+
+ServiceProfile::Mode ServiceProfile::mode(const QBluetoothUuid &service) const
+{
+    if (eager.contains(service))
+        return Eager;
+    if (lazy.contains(service))
+        return Lazy;
+
+    return Skip;
+}
+
+ServiceProfile ServiceProfile::minimal()
+{
+    ServiceProfile profile;
+    profile.name = "minimal";
+    profile.eager << CaptoGloveUuids::fingerPositionService()
+                  << QBluetoothUuid(QBluetoothUuid::BatteryService)
+                  << QBluetoothUuid(QBluetoothUuid::DeviceInformation);
+    profile.lazy << QBluetoothUuid(QBluetoothUuid::GenericAccess);
+    return profile;
+}
+
+ServiceProfile ServiceProfile::full()
+{
+    ServiceProfile profile = minimal();
+    profile.name = "full";
+    profile.eager << profile.lazy
+                  << QBluetoothUuid(QBluetoothUuid::HumanInterfaceDevice)
+                  << QBluetoothUuid(QBluetoothUuid::ScanParameters);
+    profile.lazy.clear();
+    return profile;
+}
+
+ServiceProfile ServiceProfile::fromStrings(const QString &name, const QStringList &eager, const QStringList &lazy)
+{
+    const QString wanted = name.trimmed().toLower();
+    if (wanted == "full")
+        return full();
+    if (wanted == "minimal" || (eager.isEmpty() && lazy.isEmpty()))
+        return minimal();
+
+    ServiceProfile profile;
+    profile.name = wanted.isEmpty() ? QString("custom") : wanted;
+    for (const QString &service : eager) {
+        const QBluetoothUuid uuid = serviceFromString(service);
+        if (!uuid.isNull())
+            profile.eager << uuid;
+    }
+    for (const QString &service : lazy) {
+        const QBluetoothUuid uuid = serviceFromString(service);
+        if (!uuid.isNull())
+            profile.lazy << uuid;
+    }
+
+    return profile;
+}
+
+QBluetoothUuid ServiceProfile::serviceFromString(const QString &service)
+{
+    const QString s = service.trimmed().toLower();
+    if (s == "finger")
+        return CaptoGloveUuids::fingerPositionService();
+    if (s == "battery")
+        return QBluetoothUuid(QBluetoothUuid::BatteryService);
+    if (s == "deviceinfo")
+        return QBluetoothUuid(QBluetoothUuid::DeviceInformation);
+    if (s == "genericaccess")
+        return QBluetoothUuid(QBluetoothUuid::GenericAccess);
+    if (s == "hid")
+        return QBluetoothUuid(QBluetoothUuid::HumanInterfaceDevice);
+    if (s == "scanparameters")
+        return QBluetoothUuid(QBluetoothUuid::ScanParameters);
+
+    if (s.startsWith("0x")) {
+        bool ok = false;
+        const quint32 value = s.mid(2).toUInt(&ok, 16);
+        if (!ok)
+            return QBluetoothUuid();
+        return value <= 0xffff ? QBluetoothUuid(static_cast<quint16>(value)) : QBluetoothUuid(value);
+    }
+
+    return QBluetoothUuid(s);
+}
@@ -0,0 +1,34 @@
+#ifndef SERVICEPROFILE_H
+#define SERVICEPROFILE_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <QtBluetooth/QBluetoothUuid>
+
+// Services the application needs. Eager services get a service object and
+// detail discovery right after connecting, lazy ones only when first accessed
+// through CaptoGloveAPI::connectToService or by the device information read
+// (deviceinfo, genericaccess), everything else is never touched.
+struct ServiceProfile
+{
+    enum Mode { Skip, Lazy, Eager };
+
+    QString name;
+    QList<QBluetoothUuid> eager;
+    QList<QBluetoothUuid> lazy;
+
+    Mode mode(const QBluetoothUuid &service) const;
+    bool wants(const QBluetoothUuid &service) const { return mode(service) == Eager; }
+
+    static ServiceProfile minimal();        // finger positions, battery, device information
+    static ServiceProfile full();           // every service the API knows
+    // Names (finger, battery, deviceinfo, genericaccess, hid, scanparameters) or uuids
+    static ServiceProfile fromStrings(const QString &name, const QStringList &eager, const QStringList &lazy);
+
+    // 0x180f style short forms as printed by ServiceInfo, names or full uuids
+    static QBluetoothUuid serviceFromString(const QString &service);
+};
+
+#endif // SERVICEPROFILE_H
@@ -0,0 +1,427 @@
+#include "sessionanalyzer.h"
+#include "sessionrecording.h"
+#include "payloadlayout.h"
+#include "sequencetracker.h"
+#include "handmodel.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Records replayed before a chunk so sequence tracking and gesture state continue across chunk borders
+const int WarmupRecords = 64;
+const int ReadRecords = 4096;
+
+// Notification interval histogram, the last bin collects everything above
+const double BinMs = 0.25;
+const int IntervalBins = 800;
+
+// Grasp: mean flexion of all fingers rising above GraspOn, released below GraspOff
+const float GraspOn = 0.7f;
+const float GraspOff = 0.3f;
+
+const char *const FingerNames[HandPose::FingerCount] = { "thumb", "index", "middle", "ring", "little" };
+
+struct Session
+{
+    QString path;
+    SessionHeader header;
+    qint64 records = 0;
+    const PayloadFormat *format = nullptr;
+};
+
+struct Chunk
+{
+    int session;
+    qint64 first;
+    qint64 count;
+};
+
+// Statistics of one chunk, merged into its session afterwards
+struct Result
+{
+    quint64 frames = 0;
+    quint64 lost = 0;
+    quint64 duplicates = 0;
+    quint64 decodeErrors = 0;
+    quint64 grasps = 0;
+    qint64 firstUs = -1;
+    qint64 lastUs = -1;
+    float minFlexion[HandPose::FingerCount];
+    float maxFlexion[HandPose::FingerCount];
+    quint64 intervals[IntervalBins] = {};
+    quint64 intervalCount = 0;
+
+    Result()
+    {
+        for (int f = 0; f < HandPose::FingerCount; ++f) {
+            minFlexion[f] = 1.0f;
+            maxFlexion[f] = 0.0f;
+        }
+    }
+
+    void merge(const Result &other)
+    {
+        frames += other.frames;
+        lost += other.lost;
+        duplicates += other.duplicates;
+        decodeErrors += other.decodeErrors;
+        grasps += other.grasps;
+        if (other.firstUs >= 0 && (firstUs < 0 || other.firstUs < firstUs))
+            firstUs = other.firstUs;
+        lastUs = qMax(lastUs, other.lastUs);
+        for (int f = 0; f < HandPose::FingerCount; ++f) {
+            minFlexion[f] = qMin(minFlexion[f], other.minFlexion[f]);
+            maxFlexion[f] = qMax(maxFlexion[f], other.maxFlexion[f]);
+        }
+        for (int i = 0; i < IntervalBins; ++i)
+            intervals[i] += other.intervals[i];
+        intervalCount += other.intervalCount;
+    }
+
+    double intervalPercentile(double q) const
+    {
+        const quint64 target = static_cast<quint64>(std::ceil(q * intervalCount));
+        quint64 seen = 0;
+        for (int i = 0; i < IntervalBins; ++i) {
+            seen += intervals[i];
+            if (seen >= target && seen > 0)
+                return (i + 1) * BinMs;
+        }
+        return 0.0;
+    }
+};
+
+struct WorkerStats
+{
+    quint64 frames = 0;
+    quint64 chunks = 0;
+    quint64 stolen = 0;
+    qint64 busyNs = 0;
+};
+
+// One deque per worker. Owners take from the front, so a file is read
+// front to back, idle workers steal from the back of the others.
+class WorkQueues
+{
+public:
+    explicit WorkQueues(int workers):
+        m_queues(static_cast<size_t>(workers))
+    {
+    }
+
+    // Only before the workers start
+    void push(int worker, int chunk)
+    {
+        m_queues[static_cast<size_t>(worker)].chunks.push_back(chunk);
+    }
+
+    bool next(int worker, int &chunk, bool &stolen)
+    {
+        const int workers = static_cast<int>(m_queues.size());
+        for (int k = 0; k < workers; ++k) {
+            Queue &queue = m_queues[static_cast<size_t>((worker + k) % workers)];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.chunks.empty())
+                continue;
+
+            stolen = k != 0;
+            if (stolen) {
+                chunk = queue.chunks.back();
+                queue.chunks.pop_back();
+            } else {
+                chunk = queue.chunks.front();
+                queue.chunks.pop_front();
+            }
+            return true;
+        }
+
+        // Nothing is added once running, empty queues mean done
+        return false;
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<int> chunks;
+    };
+
+    std::vector<Queue> m_queues;
+};
+
+void analyzeChunk(const Session &session, const Chunk &chunk, const HandModel &model, Result &result, QByteArray &buffer)
+{
+    SessionRecording recording;
+    if (!recording.open(session.path))
+        return;
+
+    SequenceTracker tracker;
+    tracker.setCounter(session.header.counterOffset, session.header.counterWidth);
+
+    const int recordSize = session.header.recordSize;
+    const qint64 end = chunk.first + chunk.count;
+    qint64 index = chunk.first - qMin<qint64>(WarmupRecords, chunk.first);
+    qint64 previousUs = -1;
+    bool grasping = false;
+    bool graspKnown = chunk.first == 0;
+    FingerFrame frame;
+    HandPose pose;
+    uchar scratch[SequenceTracker::MaxPayload];
+
+    while (index < end) {
+        const int read = recording.read(index, static_cast<int>(qMin<qint64>(ReadRecords, end - index)), buffer);
+        if (read <= 0)
+            break;
+
+        for (int i = 0; i < read; ++i, ++index) {
+            const bool counted = index >= chunk.first;
+
+            qint64 timestampUs;
+            const uchar *payload;
+            int size;
+            SessionRecording::record(buffer.constData() + i * recordSize, recordSize, timestampUs, payload, size);
+
+            frame.timestampUs = timestampUs;
+            frame.flags = FingerFrame::NoFlags;
+            int dataSize = size;
+            const uchar *channels = tracker.channelData(payload, dataSize, scratch);
+            if (!session.format->decode(channels, dataSize, frame)) {
+                if (counted)
+                    result.decodeErrors++;
+                continue;
+            }
+
+            const int missing = tracker.track(payload, size, frame);
+            if (missing < 0) {
+                if (counted)
+                    result.duplicates++;
+                continue;
+            }
+
+            model.evaluate(frame, pose);
+            float mean = 0.0f;
+            for (int f = 0; f < HandPose::FingerCount; ++f)
+                mean += pose.flexion[f];
+            mean /= HandPose::FingerCount;
+
+            // Until the warmup leaves the band between the thresholds, a mean above GraspOff
+            // counts as a grasp begun in the previous chunk, which already counted it
+            bool graspStarted = false;
+            if (!graspKnown && !counted) {
+                grasping = mean > GraspOff;
+                graspKnown = mean > GraspOn || mean < GraspOff;
+            } else if (!grasping && mean > GraspOn) {
+                grasping = true;
+                graspStarted = true;
+            } else if (grasping && mean < GraspOff) {
+                grasping = false;
+            }
+
+            if (counted) {
+                result.frames++;
+                result.lost += static_cast<quint64>(missing);
+                if (graspStarted)
+                    result.grasps++;
+
+                for (int f = 0; f < HandPose::FingerCount; ++f) {
+                    result.minFlexion[f] = qMin(result.minFlexion[f], pose.flexion[f]);
+                    result.maxFlexion[f] = qMax(result.maxFlexion[f], pose.flexion[f]);
+                }
+
+                if (previousUs >= 0) {
+                    const double intervalMs = qMax<qint64>(0, timestampUs - previousUs) / 1000.0;
+                    result.intervals[qMin(static_cast<int>(intervalMs / BinMs), IntervalBins - 1)]++;
+                    result.intervalCount++;
+                }
+
+                if (result.firstUs < 0)
+                    result.firstUs = timestampUs;
+                result.lastUs = timestampUs;
+            }
+
+            previousUs = timestampUs;
+        }
+    }
+}
+
+bool writeSummary(const QString &path, const QList<Session> &sessions, const std::vector<Result> &totals)
+{
+    QByteArray table;
+    QTextStream out(&table);
+    out << "file,glove,format,duration_s,frames,lost,duplicates,loss_rate,decode_errors,"
+           "interval_p50_ms,interval_p95_ms,interval_p99_ms,grasps";
+    for (int f = 0; f < HandPose::FingerCount; ++f)
+        out << ",rom_" << FingerNames[f];
+    out << "\n";
+
+    for (int s = 0; s < sessions.size(); ++s) {
+        const Session &session = sessions.at(s);
+        const Result &r = totals[static_cast<size_t>(s)];
+        const double duration = r.firstUs >= 0 ? (r.lastUs - r.firstUs) / 1e6 : 0.0;
+        const double lossRate = r.frames + r.lost > 0 ? static_cast<double>(r.lost) / (r.frames + r.lost) : 0.0;
+
+        out << QFileInfo(session.path).fileName() << ',' << session.header.glove << ',' << session.format->name << ','
+            << duration << ',' << r.frames << ',' << r.lost << ',' << r.duplicates << ',' << lossRate << ','
+            << r.decodeErrors << ',' << r.intervalPercentile(0.50) << ',' << r.intervalPercentile(0.95) << ','
+            << r.intervalPercentile(0.99) << ',' << r.grasps;
+        for (int f = 0; f < HandPose::FingerCount; ++f)
+            out << ',' << (r.frames > 0 ? r.maxFlexion[f] - r.minFlexion[f] : 0.0f);
+        out << "\n";
+    }
+    out.flush();
+
+    if (path.isEmpty()) {
+        fwrite(table.constData(), 1, static_cast<size_t>(table.size()), stdout);
+        return true;
+    }
+
+    QSaveFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(table) == table.size() && file.commit();
+}
+
+}
+
+int SessionAnalyzer::run(const Options &options)
+{
+    const int threads = options.threads > 0 ? options.threads : qMax(1, QThread::idealThreadCount());
+    const qint64 chunkRecords = qMax(1, options.chunkRecords);
+
+    // Recordings and their chunks
+    QList<Session> sessions;
+    QList<Chunk> chunks;
+    const QDir dir(options.directory);
+    const QStringList files = dir.entryList(QStringList() << "*.cgrec", QDir::Files, QDir::Name);
+    for (const QString &file : files) {
+        Session session;
+        session.path = dir.filePath(file);
+
+        SessionRecording recording;
+        if (!recording.open(session.path)) {
+            fprintf(stderr, "Skipping %s, not a recording\n", qPrintable(file));
+            continue;
+        }
+        session.header = recording.header();
+        session.records = recording.recordCount();
+        session.format = PayloadFormats::find(session.header.format);
+        if (!session.format) {
+            fprintf(stderr, "Unknown payload format %s in %s, using %s\n", qPrintable(session.header.format),
+                    qPrintable(file), PayloadFormats::defaultFormat().name);
+            session.format = &PayloadFormats::defaultFormat();
+        }
+
+        const int index = sessions.size();
+        sessions.append(session);
+        for (qint64 first = 0; first < session.records; first += chunkRecords)
+            chunks.append(Chunk{ index, first, qMin(chunkRecords, session.records - first) });
+    }
+
+    if (sessions.isEmpty()) {
+        fprintf(stderr, "No recordings in %s\n", qPrintable(options.directory));
+        return 1;
+    }
+
+    HandModel model;
+    configureModel(model, options.configPath);
+
+    // Whole files go to one worker each, stealing evens out the rest
+    WorkQueues queues(threads);
+    for (int c = 0; c < chunks.size(); ++c)
+        queues.push(chunks.at(c).session % threads, c);
+
+    // Written by one worker each, no sharing
+    std::vector<Result> results(static_cast<size_t>(chunks.size()));
+    std::vector<WorkerStats> workerStats(static_cast<size_t>(threads));
+
+    QElapsedTimer wall;
+    wall.start();
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < threads; ++w) {
+        workers.push_back(std::thread([&, w]() {
+            QByteArray buffer;
+            QElapsedTimer busy;
+            WorkerStats &stats = workerStats[static_cast<size_t>(w)];
+            int chunk;
+            bool stolen;
+            while (queues.next(w, chunk, stolen)) {
+                busy.start();
+                const Chunk &c = chunks.at(chunk);
+                Result &result = results[static_cast<size_t>(chunk)];
+                analyzeChunk(sessions.at(c.session), c, model, result, buffer);
+                stats.busyNs += busy.nsecsElapsed();
+                stats.frames += result.frames;
+                stats.chunks++;
+                if (stolen)
+                    stats.stolen++;
+            }
+        }));
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+
+    const double seconds = qMax<qint64>(1, wall.nsecsElapsed()) / 1e9;
+
+    std::vector<Result> totals(static_cast<size_t>(sessions.size()));
+    quint64 frames = 0;
+    for (int c = 0; c < chunks.size(); ++c) {
+        totals[static_cast<size_t>(chunks.at(c).session)].merge(results[static_cast<size_t>(c)]);
+        frames += results[static_cast<size_t>(c)].frames;
+    }
+
+    if (!writeSummary(options.output, sessions, totals)) {
+        fprintf(stderr, "Can't write summary to %s\n", qPrintable(options.output));
+        return 1;
+    }
+
+    fprintf(stderr, "Analyzed %d recordings, %llu frames in %.2f s on %d threads: %.0f frames/s, %.0f frames/s per core\n",
+            sessions.size(), static_cast<unsigned long long>(frames), seconds, threads,
+            frames / seconds, frames / seconds / threads);
+    for (int w = 0; w < threads; ++w) {
+        const WorkerStats &stats = workerStats[static_cast<size_t>(w)];
+        const double busySeconds = qMax<qint64>(1, stats.busyNs) / 1e9;
+        fprintf(stderr, "  worker %d: %llu chunks (%llu stolen), %llu frames, %.0f frames/s busy\n", w,
+                static_cast<unsigned long long>(stats.chunks), static_cast<unsigned long long>(stats.stolen),
+                static_cast<unsigned long long>(stats.frames), stats.frames / busySeconds);
+    }
+
+    return 0;
+}
+
+void SessionAnalyzer::configureModel(HandModel &model, const QString &configPath)
+{
+    if (configPath.isEmpty())
+        return;
+
+    // Same keys as CaptoGloveAPI::loadSettings
+    QSettings Setting(configPath, QSettings::IniFormat);
+    Setting.beginGroup("HandModel");
+    const QStringList channels = Setting.value("channels").toStringList();
+    if (channels.size() == HandPose::FingerCount) {
+        int fingerChannels[HandPose::FingerCount];
+        for (int f = 0; f < HandPose::FingerCount; ++f)
+            fingerChannels[f] = channels.at(f).toInt();
+        model.setChannels(fingerChannels);
+    }
+
+    const QString profilePath = Setting.value("profile").toString();
+    CalibrationProfile profile;
+    if (!profilePath.isEmpty() && profile.load(profilePath))
+        model.setCalibration(profile);
+    else if (!profilePath.isEmpty())
+        fprintf(stderr, "Can't load calibration profile %s, using the default\n", qPrintable(profilePath));
+    Setting.endGroup();
+}
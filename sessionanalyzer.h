@@ -0,0 +1,30 @@
+#ifndef SESSIONANALYZER_H
+#define SESSIONANALYZER_H
+
+#include <QString>
+
+class HandModel;
+
+// Offline statistics over a directory of recordings (see sessionrecording.h),
+// decoded with the same payload formats, sequence tracking and hand model as
+// the live stream. Files are split into record chunks that a pool of workers
+// processes with work stealing, one summary row per recording is written.
+namespace SessionAnalyzer {
+
+struct Options {
+    QString directory;
+    QString output;                     // summary CSV, empty writes to stdout
+    QString configPath;                 // [HandModel] channels and calibration profile
+    int threads = 0;                    // 0 -> one per core
+    int chunkRecords = 65536;
+};
+
+// Returns the process exit code
+int run(const Options &options);
+
+// Channels and calibration profile of [HandModel] in the config, as the live stream uses them
+void configureModel(HandModel &model, const QString &configPath);
+
+}
+
+#endif // SESSIONANALYZER_H
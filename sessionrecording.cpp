@@ -0,0 +1,237 @@
+#include "sessionrecording.h"
+#include "logger.h"
+
+#include <QtEndian>
+
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+// Sleep of the writer thread while no record is waiting
+const std::chrono::milliseconds IdleWait(20);
+
+const char Magic[8] = { 'C', 'G', 'R', 'E', 'C', 0, 0, 0 };
+const int FormatSize = 16;
+const int GloveSize = 24;
+
+// Header layout after the magic
+const int VersionOffset = 8;
+const int RecordSizeOffset = 12;
+const int CounterOffsetOffset = 16;
+const int CounterWidthOffset = 20;
+const int FormatOffset = 24;
+const int GloveOffset = FormatOffset + FormatSize;
+
+const int StdioBuffer = 64 * 1024;
+
+void putText(uchar *out, const QString &text, int size)
+{
+    const QByteArray latin = text.toLatin1().left(size - 1);
+    memcpy(out, latin.constData(), static_cast<size_t>(latin.size()));
+}
+
+QString getText(const uchar *in, int size)
+{
+    const char *text = reinterpret_cast<const char *>(in);
+    return QString::fromLatin1(text, static_cast<int>(strnlen(text, static_cast<size_t>(size))));
+}
+
+}
+
+// ############## RECORDER ##############
+SessionRecorder::~SessionRecorder()
+{
+    close();
+}
+
+bool SessionRecorder::open(const QString &path, const SessionHeader &header)
+{
+    close();
+
+    m_file = fopen(QFile::encodeName(path).constData(), "wb");
+    if (!m_file) {
+        LOG_WARNING("Can't open recording %1", path);
+        return false;
+    }
+    setvbuf(m_file, nullptr, _IOFBF, StdioBuffer);
+
+    uchar raw[SessionHeader::Size];
+    memset(raw, 0, sizeof(raw));
+    memcpy(raw, Magic, sizeof(Magic));
+    qToLittleEndian<quint32>(SessionHeader::Version, raw + VersionOffset);
+    qToLittleEndian<quint32>(RecordSize, raw + RecordSizeOffset);
+    qToLittleEndian<qint32>(header.counterOffset, raw + CounterOffsetOffset);
+    qToLittleEndian<qint32>(header.counterWidth, raw + CounterWidthOffset);
+    putText(raw + FormatOffset, header.format, FormatSize);
+    putText(raw + GloveOffset, header.glove, GloveSize);
+
+    if (fwrite(raw, sizeof(raw), 1, m_file) != 1) {
+        LOG_WARNING("Can't write recording %1", path);
+        close();
+        return false;
+    }
+
+    m_path = path;
+    m_records = 0;
+    m_truncated = 0;
+    m_dropped = 0;
+    m_writeFailures.store(0);
+    m_ring.assign(static_cast<size_t>(RingRecords) * RecordSize, 0);
+    m_head.store(0);
+    m_tail.store(0);
+
+    m_running.store(true);
+    m_thread = std::thread(&SessionRecorder::run, this);
+
+    LOG_INFO("Recording finger stream to %1", path);
+    return true;
+}
+
+void SessionRecorder::close()
+{
+    if (!m_file)
+        return;
+
+    // The writer thread finishes the appended records before it stops
+    if (m_thread.joinable()) {
+        m_running.store(false);
+        m_thread.join();
+    }
+
+    if (fclose(m_file) != 0)
+        LOG_WARNING("Closing recording %1 failed", m_path);
+    m_file = nullptr;
+    std::vector<uchar>().swap(m_ring);
+
+    LOG_INFO("Recorded %1 notifications to %2", m_records, m_path);
+    if (m_dropped > 0)
+        LOG_WARNING("Dropped %1 notifications of %2 while the writer was behind", m_dropped, m_path);
+    if (m_writeFailures.load() > 0)
+        LOG_WARNING("Failed to write %1 notifications to %2", m_writeFailures.load(), m_path);
+}
+
+void SessionRecorder::append(qint64 timestampUs, const uchar *data, int size)
+{
+    if (!m_file)
+        return;
+
+    const quint32 head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) >= static_cast<quint32>(RingRecords)) {
+        m_dropped++;
+        return;
+    }
+
+    if (size > MaxPayload) {
+        m_truncated++;
+        size = MaxPayload;
+    }
+
+    uchar *record = m_ring.data() + static_cast<size_t>(head % RingRecords) * RecordSize;
+    qToLittleEndian<qint64>(timestampUs, record);
+    qToLittleEndian<quint16>(static_cast<quint16>(size), record + 8);
+    memcpy(record + 10, data, static_cast<size_t>(size));
+    memset(record + 10 + size, 0, static_cast<size_t>(MaxPayload - size));
+
+    m_head.store(head + 1, std::memory_order_release);
+    m_records++;
+}
+
+void SessionRecorder::run()
+{
+    for (;;) {
+        const quint32 tail = m_tail.load(std::memory_order_relaxed);
+        const quint32 head = m_head.load(std::memory_order_acquire);
+        if (tail != head) {
+            // Up to the end of the ring in one write, the rest on the next pass
+            const int slot = static_cast<int>(tail % RingRecords);
+            const size_t count = qMin<size_t>(head - tail, static_cast<size_t>(RingRecords - slot));
+            const size_t written = fwrite(m_ring.data() + static_cast<size_t>(slot) * RecordSize, RecordSize, count, m_file);
+            if (written != count)
+                m_writeFailures.fetch_add(count - written);
+            m_tail.store(tail + static_cast<quint32>(count), std::memory_order_release);
+            continue;
+        }
+
+        if (!m_running.load())
+            return;
+        std::this_thread::sleep_for(IdleWait);
+    }
+}
+
+quint64 SessionRecorder::records() const
+{
+    return m_records;
+}
+
+quint64 SessionRecorder::truncated() const
+{
+    return m_truncated;
+}
+
+quint64 SessionRecorder::dropped() const
+{
+    return m_dropped;
+}
+
+quint64 SessionRecorder::writeFailures() const
+{
+    return m_writeFailures.load();
+}
+
+
+// ############## READER ##############
+bool SessionRecording::open(const QString &path)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    uchar raw[SessionHeader::Size];
+    if (m_file.read(reinterpret_cast<char *>(raw), sizeof(raw)) != sizeof(raw) || memcmp(raw, Magic, sizeof(Magic)) != 0)
+        return false;
+
+    if (qFromLittleEndian<quint32>(raw + VersionOffset) != SessionHeader::Version)
+        return false;
+
+    m_header.recordSize = static_cast<int>(qFromLittleEndian<quint32>(raw + RecordSizeOffset));
+    m_header.counterOffset = qFromLittleEndian<qint32>(raw + CounterOffsetOffset);
+    m_header.counterWidth = qFromLittleEndian<qint32>(raw + CounterWidthOffset);
+    m_header.format = getText(raw + FormatOffset, FormatSize);
+    m_header.glove = getText(raw + GloveOffset, GloveSize);
+    if (m_header.recordSize <= 10)
+        return false;
+
+    // A partly written last record (crash while recording) is ignored
+    m_recordCount = (m_file.size() - SessionHeader::Size) / m_header.recordSize;
+    return true;
+}
+
+SessionHeader SessionRecording::header() const
+{
+    return m_header;
+}
+
+qint64 SessionRecording::recordCount() const
+{
+    return m_recordCount;
+}
+
+int SessionRecording::read(qint64 first, int count, QByteArray &buffer)
+{
+    count = static_cast<int>(qMin<qint64>(count, m_recordCount - first));
+    if (count <= 0 || !m_file.seek(SessionHeader::Size + first * m_header.recordSize))
+        return 0;
+
+    buffer.resize(count * m_header.recordSize);
+    const qint64 bytes = m_file.read(buffer.data(), buffer.size());
+    return bytes < 0 ? 0 : static_cast<int>(bytes / m_header.recordSize);
+}
+
+void SessionRecording::record(const char *data, int recordSize, qint64 &timestampUs, const uchar *&payload, int &size)
+{
+    const uchar *raw = reinterpret_cast<const uchar *>(data);
+    timestampUs = qFromLittleEndian<qint64>(raw);
+    size = qMin(static_cast<int>(qFromLittleEndian<quint16>(raw + 8)), recordSize - 10);
+    payload = raw + 10;
+}
@@ -0,0 +1,94 @@
+#ifndef SESSIONRECORDING_H
+#define SESSIONRECORDING_H
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Raw finger notifications of one connection, as they arrived. Fixed size
+// little endian records after a 64 byte header, so readers can split a file
+// into record ranges without scanning it:
+//   header  "CGREC\0\0\0", version, record size, counter offset/width, format, glove
+//   record  timestamp us (int64), payload size (uint16), payload padded to the record size
+struct SessionHeader
+{
+    static const int Size = 64;
+    static const quint32 Version = 1;
+
+    QString format;                     // PayloadFormat name
+    QString glove;
+    int counterOffset = -1;             // SequenceTracker counter, -1 -> timing based
+    int counterWidth = 1;
+    int recordSize = 0;
+};
+
+// Appends to a recording from the notification path. Records are handed to a
+// writer thread through a single producer / single consumer ring, as in
+// ArrowWriter's Background mode. Records arriving while the ring is full are
+// dropped and counted.
+class SessionRecorder
+{
+public:
+    static const int MaxPayload = 30;
+    static const int RecordSize = 10 + MaxPayload;
+    static const int RingRecords = 4096;    // about 4 s of a 1 kHz stream
+
+    SessionRecorder() {}
+    ~SessionRecorder();
+
+    bool open(const QString &path, const SessionHeader &header);
+    bool isOpen() const { return m_file != nullptr; }
+    void close();
+
+    void append(qint64 timestampUs, const uchar *data, int size);
+    quint64 records() const;
+    quint64 truncated() const;          // payloads longer than MaxPayload
+    quint64 dropped() const;            // ring full, the writer was behind
+    quint64 writeFailures() const;      // records the writer thread failed to write
+
+private:
+    Q_DISABLE_COPY(SessionRecorder)
+
+    void run();
+
+    FILE *m_file = nullptr;
+    QString m_path;
+    quint64 m_records = 0;
+    quint64 m_truncated = 0;
+    quint64 m_dropped = 0;
+
+    // Records appended by the producer and written by the writer thread
+    std::vector<uchar> m_ring;
+    std::atomic<quint32> m_head{0};
+    std::atomic<quint32> m_tail{0};
+    std::atomic<bool> m_running{false};
+    std::atomic<quint64> m_writeFailures{0};
+    std::thread m_thread;
+};
+
+// Random access reader, one instance per thread
+class SessionRecording
+{
+public:
+    bool open(const QString &path);
+    SessionHeader header() const;
+    qint64 recordCount() const;
+
+    // Reads up to count records starting at first into buffer, returns the number read
+    int read(qint64 first, int count, QByteArray &buffer);
+
+    // Splits one record of buffer
+    static void record(const char *data, int recordSize, qint64 &timestampUs, const uchar *&payload, int &size);
+
+private:
+    QFile m_file;
+    SessionHeader m_header;
+    qint64 m_recordCount = 0;
+};
+
+#endif // SESSIONRECORDING_H
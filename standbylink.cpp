@@ -0,0 +1,191 @@
+#include "standbylink.h"
+#include "captogloveuuids.h"
+#include "connectiontrace.h"
+#include "logger.h"
+
+StandbyLink::StandbyLink(QObject *parent):
+    QObject(parent)
+{
+    m_clock.start();
+    m_retryTimer.setSingleShot(true);
+    m_retryTimer.setInterval(1000);
+    connect(&m_retryTimer, &QTimer::timeout, this, &StandbyLink::retry);
+
+    connect(&m_subscriptions, &SubscriptionManager::subscribed, this, [this](const QBluetoothUuid &characteristic) {
+        if (characteristic != CaptoGloveUuids::fingerPositions())
+            return;
+        m_armed = true;
+        LOG_INFO("Standby glove %1 is armed", name());
+        emit armed();
+    });
+
+    setCharacteristics(QList<QBluetoothUuid>() << CaptoGloveUuids::fingerPositions());
+}
+
+StandbyLink::~StandbyLink()
+{
+    m_wanted = false;
+    releaseController();
+}
+
+void StandbyLink::setCharacteristics(const QList<QBluetoothUuid> &characteristics)
+{
+    m_subscriptions.clear();
+    for (const QBluetoothUuid &characteristic : characteristics)
+        m_subscriptions.subscribe(CaptoGloveUuids::fingerPositionService(), characteristic);
+}
+
+void StandbyLink::setRetryMs(int retryMs)
+{
+    m_retryTimer.setInterval(qMax(0, retryMs));
+}
+
+void StandbyLink::connectTo(const QBluetoothDeviceInfo &info, bool randomAddress)
+{
+    releaseController();
+    m_device = info;
+    m_randomAddress = randomAddress;
+    m_wanted = true;
+
+    if (m_traceTrack < 0) {
+        m_traceTrack = ConnectionTrace::instance()->addTrack(QString("Standby %1").arg(info.name()));
+        m_subscriptions.setTraceTrack(m_traceTrack);
+    }
+
+    m_controller = QLowEnergyController::createCentral(info);
+    m_controller->setRemoteAddressType(randomAddress ? QLowEnergyController::RandomAddress
+                                                     : QLowEnergyController::PublicAddress);
+    connect(m_controller, &QLowEnergyController::connected, this, &StandbyLink::deviceConnected);
+    connect(m_controller, &QLowEnergyController::disconnected, this, &StandbyLink::deviceDisconnected);
+    connect(m_controller, &QLowEnergyController::discoveryFinished, this, &StandbyLink::discoveryFinished);
+    connect(m_controller, QOverload<QLowEnergyController::Error>::of(&QLowEnergyController::error), this, [this]() {
+        LOG_WARNING("Standby glove %1: %2", name(), m_controller->errorString());
+        if (m_controller->state() == QLowEnergyController::UnconnectedState && m_wanted)
+            m_retryTimer.start();
+    });
+
+    LOG_INFO("Connecting to standby glove %1", info.name());
+    retry();
+}
+
+void StandbyLink::disconnectFromDevice()
+{
+    m_wanted = false;
+    m_retryTimer.stop();
+    releaseController();
+}
+
+void StandbyLink::reconnect()
+{
+    if (!m_controller)
+        return;
+
+    if (m_controller->state() != QLowEnergyController::UnconnectedState)
+        m_controller->disconnectFromDevice();
+    else
+        retry();
+}
+
+void StandbyLink::reapply()
+{
+    m_subscriptions.reapply(CaptoGloveUuids::fingerPositions());
+}
+
+void StandbyLink::setDelivering(bool delivering)
+{
+    m_delivering = delivering;
+}
+
+bool StandbyLink::isDelivering() const
+{
+    return m_delivering;
+}
+
+bool StandbyLink::isArmed() const
+{
+    return m_armed;
+}
+
+bool StandbyLink::isStreaming(qint64 thresholdMs) const
+{
+    return m_armed && m_lastNotificationMs >= 0 && m_clock.elapsed() - m_lastNotificationMs < thresholdMs;
+}
+
+QString StandbyLink::name() const
+{
+    return m_device.name();
+}
+
+void StandbyLink::deviceConnected()
+{
+    ConnectionTrace::instance()->end(m_traceConnect);
+    m_traceConnect = -1;
+
+    // Service object of the previous connection is stale
+    delete m_service;
+    m_service = nullptr;
+    m_controller->discoverServices();
+}
+
+void StandbyLink::deviceDisconnected()
+{
+    m_subscriptions.reset();
+    m_armed = false;
+    m_lastNotificationMs = -1;
+    ConnectionTrace::instance()->instant(m_traceTrack, "disconnected");
+    LOG_WARNING("Standby glove %1 disconnected", name());
+    emit lost();
+
+    if (m_wanted)
+        m_retryTimer.start();
+}
+
+void StandbyLink::discoveryFinished()
+{
+    // Only the finger service, nothing else is needed to take over the stream
+    m_service = m_controller->createServiceObject(CaptoGloveUuids::fingerPositionService(), this);
+    if (!m_service) {
+        LOG_WARNING("Standby glove %1 has no finger service", name());
+        return;
+    }
+
+    connect(m_service, &QLowEnergyService::characteristicChanged, this, &StandbyLink::characteristicChanged);
+    m_subscriptions.attach(m_service);
+    m_service->discoverDetails();
+}
+
+void StandbyLink::characteristicChanged(const QLowEnergyCharacteristic &characteristic, const QByteArray &value)
+{
+    m_lastNotificationMs = m_clock.elapsed();
+    if (m_delivering)
+        emit notified(characteristic, value);
+}
+
+void StandbyLink::retry()
+{
+    if (!m_controller || !m_wanted || m_controller->state() != QLowEnergyController::UnconnectedState)
+        return;
+
+    ConnectionTrace::instance()->end(m_traceConnect);
+    m_traceConnect = ConnectionTrace::instance()->begin(m_traceTrack, "connect", "standby");
+    m_controller->connectToDevice();
+}
+
+void StandbyLink::releaseController()
+{
+    m_armed = false;
+    m_lastNotificationMs = -1;
+    m_subscriptions.reset();
+    ConnectionTrace::instance()->end(m_traceConnect);
+    m_traceConnect = -1;
+
+    delete m_service;
+    m_service = nullptr;
+    if (m_controller) {
+        // No lost() or retry for a link that is dropped on purpose
+        m_controller->disconnect(this);
+        m_controller->disconnectFromDevice();
+        delete m_controller;
+        m_controller = nullptr;
+    }
+}
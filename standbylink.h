@@ -0,0 +1,75 @@
+#ifndef STANDBYLINK_H
+#define STANDBYLINK_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include <QtBluetooth/QBluetoothDeviceInfo>
+#include <QtBluetooth/QLowEnergyController>
+#include <QtBluetooth/QLowEnergyService>
+
+#include "subscriptionmanager.h"
+
+// Second glove kept hot for failover: connected, finger service discovered
+// and notifications enabled, but its samples are only delivered while it is
+// the active source. Until then every notification just proves the link is
+// alive. The link reconnects on its own until disconnectFromDevice().
+class StandbyLink : public QObject
+{
+    Q_OBJECT
+public:
+    StandbyLink(QObject *parent = nullptr);
+    ~StandbyLink();
+
+    // Characteristics of the finger service to keep armed, before connectTo()
+    void setCharacteristics(const QList<QBluetoothUuid> &characteristics);
+    void setRetryMs(int retryMs);
+
+    void connectTo(const QBluetoothDeviceInfo &info, bool randomAddress);
+    void disconnectFromDevice();
+    // Drops the link, it comes back through the retry
+    void reconnect();
+    // Writes the finger CCCD again
+    void reapply();
+
+    void setDelivering(bool delivering);
+    bool isDelivering() const;
+    bool isArmed() const;
+    // Armed and a notification arrived within thresholdMs
+    bool isStreaming(qint64 thresholdMs) const;
+    QString name() const;
+
+Q_SIGNALS:
+    void armed();
+    void lost();
+    void notified(const QLowEnergyCharacteristic &characteristic, const QByteArray &value);
+
+private slots:
+    void deviceConnected();
+    void deviceDisconnected();
+    void discoveryFinished();
+    void characteristicChanged(const QLowEnergyCharacteristic &characteristic, const QByteArray &value);
+    void retry();
+
+private:
+    void releaseController();
+
+    QLowEnergyController *m_controller = nullptr;
+    QLowEnergyService *m_service = nullptr;
+    SubscriptionManager m_subscriptions;
+    QBluetoothDeviceInfo m_device;
+    bool m_randomAddress = true;
+
+    bool m_wanted = false;
+    bool m_armed = false;
+    bool m_delivering = false;
+    QElapsedTimer m_clock;
+    qint64 m_lastNotificationMs = -1;
+
+    QTimer m_retryTimer;
+    int m_traceTrack = -1;
+    int m_traceConnect = -1;
+};
+
+#endif // STANDBYLINK_H
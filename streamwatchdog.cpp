@@ -0,0 +1,158 @@
+#include "streamwatchdog.h"
+#include "logger.h"
+
+namespace {
+// Samples before the learned cadence is trusted, until then the threshold is fixed
+const int LearnSamples = 16;
+const qint64 UnlearnedThresholdMs = 500;
+const double IntervalAlpha = 0.05;
+// A single late sample must not stretch the learned cadence
+const double MaxIntervalGrowth = 4.0;
+}
+
+StreamWatchdog::StreamWatchdog(QObject *parent):
+    QObject(parent)
+{
+    m_clock.start();
+    connect(&m_checkTimer, &QTimer::timeout, this, &StreamWatchdog::check);
+    setSettings(Settings());
+}
+
+void StreamWatchdog::setSettings(const Settings &settings)
+{
+    m_settings = settings;
+    m_checkTimer.setInterval(qMax(1, m_settings.checkMs));
+}
+
+void StreamWatchdog::arm()
+{
+    const qint64 now = nowUs();
+    m_armed = true;
+    m_lastSampleUs = now;
+    m_skipInterval = true;
+
+    // A running recovery step gets its full time on the new link
+    if (m_stage != Watching)
+        m_stageStartedUs = now;
+
+    if (!m_checkTimer.isActive())
+        m_checkTimer.start();
+}
+
+void StreamWatchdog::suspend()
+{
+    m_armed = false;
+    m_checkTimer.stop();
+}
+
+void StreamWatchdog::feed()
+{
+    const qint64 now = nowUs();
+
+    if (m_stage != Watching) {
+        const Stage stage = m_stage;
+        const qint64 recoverMs = (now - m_detectedUs) / 1000;
+        m_stage = Watching;
+        m_lastSampleUs = now;
+        m_skipInterval = true;
+        LOG_INFO("Stream recovered after %1 ms at stage %2", recoverMs, static_cast<int>(stage));
+        emit recovered(m_detectMs, recoverMs, stage);
+        return;
+    }
+
+    if (!m_skipInterval) {
+        double interval = static_cast<double>(now - m_lastSampleUs);
+        if (m_samples == 0) {
+            m_intervalUs = interval;
+        } else {
+            interval = qMin(interval, m_intervalUs * MaxIntervalGrowth);
+            m_intervalUs += IntervalAlpha * (interval - m_intervalUs);
+        }
+        m_samples++;
+    }
+
+    m_skipInterval = false;
+    m_lastSampleUs = now;
+}
+
+bool StreamWatchdog::isStreaming() const
+{
+    return m_armed && m_stage == Watching;
+}
+
+StreamWatchdog::Stage StreamWatchdog::stage() const
+{
+    return m_stage;
+}
+
+double StreamWatchdog::expectedIntervalMs() const
+{
+    return m_intervalUs / 1000.0;
+}
+
+qint64 StreamWatchdog::stallThresholdMs() const
+{
+    if (m_samples < LearnSamples)
+        return qMax(static_cast<qint64>(m_settings.minStallMs), UnlearnedThresholdMs);
+
+    const qint64 learned = static_cast<qint64>(m_settings.missedIntervals * m_intervalUs / 1000.0);
+    return qMax(static_cast<qint64>(m_settings.minStallMs), learned);
+}
+
+void StreamWatchdog::check()
+{
+    if (!m_armed)
+        return;
+
+    const qint64 now = nowUs();
+    if (m_stage == Watching) {
+        const qint64 sinceLastMs = (now - m_lastSampleUs) / 1000;
+        if (sinceLastMs < stallThresholdMs())
+            return;
+
+        m_detectedUs = now;
+        m_detectMs = sinceLastMs;
+        m_stage = Resubscribe;
+        m_stageStartedUs = now;
+        m_stageMs = m_settings.stageMs;
+        LOG_WARNING("Stream stalled, no notification for %1 ms (expected every %2 ms)",
+                    sinceLastMs, expectedIntervalMs());
+        emit stallDetected(sinceLastMs);
+        emit resubscribeRequested();
+        return;
+    }
+
+    if ((now - m_stageStartedUs) / 1000 >= m_stageMs)
+        escalate(now);
+}
+
+void StreamWatchdog::escalate(qint64 now)
+{
+    m_stageStartedUs = now;
+
+    switch (m_stage) {
+    case Resubscribe:
+        m_stage = Reread;
+        LOG_WARNING("Stream still stalled, re-reading");
+        emit rereadRequested();
+        break;
+    case Reread:
+        m_stage = Reconnect;
+        LOG_WARNING("Stream still stalled, reconnecting");
+        emit reconnectRequested();
+        break;
+    case Reconnect:
+        // Keep reconnecting, backing off
+        m_stageMs = qMin(m_stageMs * 2, m_settings.maxReconnectMs);
+        LOG_WARNING("Stream still stalled, reconnecting again in %1 ms", m_stageMs);
+        emit reconnectRequested();
+        break;
+    case Watching:
+        break;
+    }
+}
+
+qint64 StreamWatchdog::nowUs() const
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
@@ -0,0 +1,80 @@
+#ifndef STREAMWATCHDOG_H
+#define STREAMWATCHDOG_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+// Learns the notification cadence of one glove and declares a stall once
+// missedIntervals expected samples did not arrive. Recovery escalates from
+// re-enabling notifications to re-reading to a full reconnect until data
+// flows again.
+class StreamWatchdog : public QObject
+{
+    Q_OBJECT
+public:
+    enum Stage {
+        Watching,
+        Resubscribe,
+        Reread,
+        Reconnect
+    };
+    Q_ENUM(Stage)
+
+    struct Settings {
+        int missedIntervals = 4;
+        int minStallMs = 100;           // floor of the stall threshold
+        int checkMs = 25;               // detection granularity
+        int stageMs = 500;              // time each recovery step gets before the next one
+        int maxReconnectMs = 10000;     // reconnect attempts back off up to this
+    };
+
+    StreamWatchdog(QObject *parent = nullptr);
+
+    void setSettings(const Settings &settings);
+
+    // Streams are live, start expecting data
+    void arm();
+    // Link is down on purpose or for a reconnect, stall state is kept
+    void suspend();
+
+    // Hot path, once per notification
+    void feed();
+
+    bool isStreaming() const;
+    Stage stage() const;
+    double expectedIntervalMs() const;
+    qint64 stallThresholdMs() const;
+
+Q_SIGNALS:
+    void stallDetected(qint64 sinceLastSampleMs);
+    void recovered(qint64 detectMs, qint64 recoverMs, StreamWatchdog::Stage stage);
+    void resubscribeRequested();
+    void rereadRequested();
+    void reconnectRequested();
+
+private slots:
+    void check();
+
+private:
+    void escalate(qint64 now);
+    qint64 nowUs() const;
+
+    Settings m_settings;
+    QTimer m_checkTimer;
+    QElapsedTimer m_clock;
+
+    bool m_armed = false;
+    qint64 m_lastSampleUs = 0;
+    bool m_skipInterval = true;         // next gap is connection setup or a stall, not cadence
+    double m_intervalUs = 0.0;          // EMA of the notification interval
+    int m_samples = 0;
+
+    Stage m_stage = Watching;
+    qint64 m_detectedUs = 0;            // when the current stall was declared
+    qint64 m_detectMs = 0;
+    qint64 m_stageStartedUs = 0;
+    int m_stageMs = 0;
+};
+
+#endif // STREAMWATCHDOG_H
@@ -0,0 +1,228 @@
+#include "subscriptionmanager.h"
+#include "logger.h"
+#include "connectiontrace.h"
+
+#include <QtBluetooth/QLowEnergyDescriptor>
+
+SubscriptionManager::SubscriptionManager(QObject *parent):
+    QObject(parent)
+{
+}
+
+void SubscriptionManager::subscribe(const QBluetoothUuid &service, const QBluetoothUuid &characteristic, bool indicate)
+{
+    for (const Subscription &s : m_subscriptions) {
+        if (s.service == service && s.characteristic == characteristic)
+            return;
+    }
+
+    Subscription subscription;
+    subscription.service = service;
+    subscription.characteristic = characteristic;
+    subscription.indicate = indicate;
+    m_subscriptions.append(subscription);
+    m_done = false;
+}
+
+void SubscriptionManager::clear()
+{
+    m_subscriptions.clear();
+    m_done = false;
+}
+
+void SubscriptionManager::attach(QLowEnergyService *service)
+{
+    if (!service)
+        return;
+
+    bool wanted = false;
+    for (Subscription &s : m_subscriptions) {
+        if (s.service == service->serviceUuid()) {
+            s.serviceObject = service;
+            wanted = true;
+        }
+    }
+    if (!wanted)
+        return;
+
+    if (!m_sinceAttach.isValid())
+        m_sinceAttach.start();
+
+    connect(service, &QLowEnergyService::stateChanged, this, &SubscriptionManager::serviceStateChanged, Qt::UniqueConnection);
+    connect(service, &QLowEnergyService::descriptorWritten, this, &SubscriptionManager::descriptorWritten, Qt::UniqueConnection);
+    connect(service, QOverload<QLowEnergyService::ServiceError>::of(&QLowEnergyService::error),
+            this, &SubscriptionManager::serviceError, Qt::UniqueConnection);
+
+    if (service->state() == QLowEnergyService::ServiceDiscovered)
+        writeAll(service);
+}
+
+void SubscriptionManager::attachDone()
+{
+    // Not advertised, skipped by the service profile or failed to open
+    for (Subscription &s : m_subscriptions) {
+        if (s.state == Pending && !s.serviceObject) {
+            LOG_DEBUG("Not subscribing to %1, service not opened", s.characteristic.toString());
+            s.state = Unavailable;
+        }
+    }
+
+    checkDone();
+}
+
+void SubscriptionManager::reset()
+{
+    for (Subscription &s : m_subscriptions) {
+        s.state = Pending;
+        s.attempts = 0;
+        s.descriptorHandle = 0;
+        s.serviceObject = nullptr;
+    }
+
+    m_sinceAttach.invalidate();
+    m_done = false;
+}
+
+void SubscriptionManager::reapply(const QBluetoothUuid &characteristic)
+{
+    for (Subscription &s : m_subscriptions) {
+        if (s.characteristic != characteristic || !s.serviceObject)
+            continue;
+
+        LOG_INFO("Subscribing to %1 again", s.characteristic.toString());
+        s.state = Pending;
+        s.attempts = 0;
+        writeAll(s.serviceObject);
+    }
+}
+
+void SubscriptionManager::setTraceTrack(int track)
+{
+    m_traceTrack = track;
+}
+
+QList<SubscriptionManager::Subscription> SubscriptionManager::subscriptions() const
+{
+    return m_subscriptions;
+}
+
+bool SubscriptionManager::allConfirmed() const
+{
+    for (const Subscription &s : m_subscriptions) {
+        if (s.state != Confirmed && s.state != Unavailable)
+            return false;
+    }
+
+    return true;
+}
+
+void SubscriptionManager::serviceStateChanged(QLowEnergyService::ServiceState state)
+{
+    if (state == QLowEnergyService::ServiceDiscovered)
+        writeAll(qobject_cast<QLowEnergyService *>(sender()));
+}
+
+void SubscriptionManager::writeAll(QLowEnergyService *service)
+{
+    if (!service)
+        return;
+
+    // No waiting between the writes, the controller queues them
+    for (Subscription &s : m_subscriptions) {
+        if (s.serviceObject != service || (s.state != Pending && s.state != Failed))
+            continue;
+
+        const QLowEnergyCharacteristic characteristic = service->characteristic(s.characteristic);
+        const QLowEnergyDescriptor cccd = characteristic.isValid()
+                ? characteristic.descriptor(QBluetoothUuid::ClientCharacteristicConfiguration)
+                : QLowEnergyDescriptor();
+        if (!cccd.isValid()) {
+            LOG_WARNING("Can't subscribe to %1, no CCCD", s.characteristic.toString());
+            s.state = Unavailable;
+            continue;
+        }
+
+        s.descriptorHandle = cccd.handle();
+        s.state = Written;
+        ++s.attempts;
+        s.traceSpan = ConnectionTrace::instance()->begin(m_traceTrack, "writeDescriptor", s.characteristic.toString());
+        service->writeDescriptor(cccd, QByteArray::fromHex(s.indicate ? "0200" : "0100"));
+    }
+
+    checkDone();
+}
+
+void SubscriptionManager::descriptorWritten(const QLowEnergyDescriptor &descriptor, const QByteArray &value)
+{
+    // Disabling writes (0000) are not ours to track
+    if (value == QByteArray::fromHex("0000"))
+        return;
+
+    QLowEnergyService *service = qobject_cast<QLowEnergyService *>(sender());
+    for (Subscription &s : m_subscriptions) {
+        if (s.state == Written && s.serviceObject == service && s.descriptorHandle == descriptor.handle()) {
+            s.state = Confirmed;
+            ConnectionTrace::instance()->end(s.traceSpan);
+            LOG_DEBUG("Subscribed to %1", s.characteristic.toString());
+            emit subscribed(s.characteristic);
+        }
+    }
+
+    checkDone();
+}
+
+void SubscriptionManager::serviceError(QLowEnergyService::ServiceError error)
+{
+    if (error != QLowEnergyService::DescriptorWriteError)
+        return;
+
+    // The error doesn't say which write failed, all outstanding ones are written again
+    // until they run out of attempts
+    QLowEnergyService *service = qobject_cast<QLowEnergyService *>(sender());
+    bool retry = false;
+    for (Subscription &s : m_subscriptions) {
+        if (s.state != Written || s.serviceObject != service)
+            continue;
+
+        ConnectionTrace::instance()->end(s.traceSpan);
+        if (s.attempts < MaxAttempts) {
+            LOG_INFO("Subscribing to %1 failed, attempt %2 of %3", s.characteristic.toString(), s.attempts, static_cast<int>(MaxAttempts));
+            s.state = Pending;
+            retry = true;
+        } else {
+            LOG_WARNING("Subscribing to %1 failed, giving up", s.characteristic.toString());
+            s.state = Failed;
+            emit subscriptionFailed(s.characteristic);
+        }
+    }
+
+    if (retry)
+        writeAll(service);
+    else
+        checkDone();
+}
+
+bool SubscriptionManager::settled() const
+{
+    for (const Subscription &s : m_subscriptions) {
+        if (s.state == Pending || s.state == Written)
+            return false;
+    }
+
+    return true;
+}
+
+void SubscriptionManager::checkDone()
+{
+    if (m_done || m_subscriptions.isEmpty() || !settled())
+        return;
+
+    int live = 0;
+    for (const Subscription &s : m_subscriptions)
+        live += s.state == Confirmed ? 1 : 0;
+
+    m_done = true;
+    LOG_INFO("%1 of %2 streams live %3 ms after service discovery",
+             live, m_subscriptions.size(), m_sinceAttach.isValid() ? m_sinceAttach.elapsed() : qint64(0));
+    emit allSubscribed();
+}
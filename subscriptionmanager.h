@@ -0,0 +1,81 @@
+#ifndef SUBSCRIPTIONMANAGER_H
+#define SUBSCRIPTIONMANAGER_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QElapsedTimer>
+
+#include <QtBluetooth/QLowEnergyService>
+#include <QtBluetooth/QBluetoothUuid>
+
+// Keeps a declarative list of characteristics to stream. All CCCD writes of a
+// service are queued back to back as soon as its details are discovered and
+// are applied again for the service objects of every new connection.
+class SubscriptionManager : public QObject
+{
+    Q_OBJECT
+public:
+    enum State {
+        Pending,        // service not discovered yet
+        Written,        // CCCD write queued, waiting for descriptorWritten
+        Confirmed,
+        Unavailable,    // service, characteristic or its CCCD missing on this glove, or service not opened
+        Failed          // CCCD write failed MaxAttempts times on this connection
+    };
+
+    static const int MaxAttempts = 3;
+
+    struct Subscription {
+        QBluetoothUuid service;
+        QBluetoothUuid characteristic;
+        bool indicate = false;
+        State state = Pending;
+        QLowEnergyHandle descriptorHandle = 0;
+        QPointer<QLowEnergyService> serviceObject;
+        int traceSpan = -1;
+        int attempts = 0;
+    };
+
+    SubscriptionManager(QObject *parent = nullptr);
+
+    void subscribe(const QBluetoothUuid &service, const QBluetoothUuid &characteristic, bool indicate = false);
+    void clear();
+
+    // Hooks a freshly created service object, writes its CCCDs once discovered
+    void attach(QLowEnergyService *service);
+    // All services of this connection are attached, the ones left out won't come
+    void attachDone();
+    // Connection lost, everything has to be written again on the next one
+    void reset();
+    // Writes the CCCD of an already confirmed characteristic again, for a glove that silently dropped it
+    void reapply(const QBluetoothUuid &characteristic);
+
+    QList<Subscription> subscriptions() const;
+    bool allConfirmed() const;
+
+    // CCCD writes show up on this ConnectionTrace track
+    void setTraceTrack(int track);
+
+Q_SIGNALS:
+    void subscribed(const QBluetoothUuid &characteristic);
+    void subscriptionFailed(const QBluetoothUuid &characteristic);
+    void allSubscribed();
+
+private slots:
+    void serviceStateChanged(QLowEnergyService::ServiceState state);
+    void descriptorWritten(const QLowEnergyDescriptor &descriptor, const QByteArray &value);
+    void serviceError(QLowEnergyService::ServiceError error);
+
+private:
+    void writeAll(QLowEnergyService *service);
+    bool settled() const;
+    void checkDone();
+
+    QList<Subscription> m_subscriptions;
+    QElapsedTimer m_sinceAttach;
+    bool m_done = false;
+    int m_traceTrack = -1;
+};
+
+#endif // SUBSCRIPTIONMANAGER_H
@@ -0,0 +1,58 @@
+#include "wakeupfd.h"
+
+#include <QtGlobal>
+
+#ifdef LINUX
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+
+WakeupFd::WakeupFd():
+    m_fd(-1)
+{
+#ifdef LINUX
+    m_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+}
+
+WakeupFd::~WakeupFd()
+{
+#ifdef LINUX
+    if (m_fd >= 0)
+        close(m_fd);
+#endif
+}
+
+int WakeupFd::fd() const
+{
+    return m_fd;
+}
+
+void WakeupFd::notify()
+{
+    if (m_fd < 0 || m_signalled.exchange(true))
+        return;
+
+#ifdef LINUX
+    const uint64_t one = 1;
+    ssize_t written = write(m_fd, &one, sizeof(one));
+    Q_UNUSED(written);
+#endif
+}
+
+void WakeupFd::clear()
+{
+    // Nothing written since the last clear, keep the poll path free of syscalls
+    if (m_fd < 0 || !m_signalled.load())
+        return;
+
+#ifdef LINUX
+    // Counter back to zero first, then allow the next notify to write again
+    uint64_t value;
+    ssize_t got = read(m_fd, &value, sizeof(value));
+    Q_UNUSED(got);
+#endif
+    m_signalled.store(false);
+}
@@ -0,0 +1,41 @@
+#ifndef WAKEUPFD_H
+#define WAKEUPFD_H
+
+#include <atomic>
+
+// Pollable file descriptor (eventfd) that becomes readable when a queue gains
+// data. Signalling is edge coalesced: only the first notify after a drain
+// touches the descriptor, so one wakeup covers any number of queued items.
+// Only available on Linux, fd() is -1 elsewhere.
+class WakeupFd
+{
+public:
+    WakeupFd();
+    ~WakeupFd();
+
+    int fd() const;
+
+    // Producer, after the item is visible in the queue
+    void notify();
+
+    // Consumer, after it emptied the queue. stillPending is re-checked queue
+    // state so an item pushed during the drain is not missed.
+    template <typename Pending>
+    void drained(Pending stillPending)
+    {
+        clear();
+        if (stillPending())
+            notify();
+    }
+
+private:
+    WakeupFd(const WakeupFd &) = delete;
+    WakeupFd &operator=(const WakeupFd &) = delete;
+
+    void clear();
+
+    int m_fd;
+    std::atomic<bool> m_signalled{false};
+};
+
+#endif // WAKEUPFD_H
@@ -0,0 +1,199 @@
+#include "writequeue.h"
+#include "logger.h"
+
+#include <QtBluetooth/QLowEnergyCharacteristic>
+
+#include <cmath>
+
+namespace {
+// Until the controller reports the negotiated one
+const double DefaultIntervalMs = 15.0;
+}
+
+WriteQueue::WriteQueue(QObject *parent):
+    QObject(parent)
+{
+    m_clock.start();
+    connect(&m_creditTimer, &QTimer::timeout, this, &WriteQueue::refillCredits);
+    setConnectionInterval(DefaultIntervalMs);
+}
+
+void WriteQueue::setService(QLowEnergyService *service)
+{
+    if (m_service)
+        disconnect(m_service, nullptr, this, nullptr);
+
+    m_service = service;
+    m_awaitingResponse = false;
+    m_credits = m_maxCredits;
+    if (!service)
+        return;
+
+    connect(service, &QLowEnergyService::characteristicWritten, this, &WriteQueue::characteristicWritten);
+    connect(service, QOverload<QLowEnergyService::ServiceError>::of(&QLowEnergyService::error),
+            this, &WriteQueue::serviceError);
+    connect(service, &QLowEnergyService::stateChanged, this, &WriteQueue::pump);
+}
+
+void WriteQueue::setConnectionInterval(double intervalMs)
+{
+    m_creditTimer.setInterval(qMax(1, static_cast<int>(std::ceil(intervalMs))));
+}
+
+void WriteQueue::setCredits(int creditsPerInterval)
+{
+    m_maxCredits = qMax(1, creditsPerInterval);
+    m_credits = qMin(m_credits, m_maxCredits);
+}
+
+void WriteQueue::setMaxDepth(int maxDepth)
+{
+    m_maxDepth = qMax(1, maxDepth);
+}
+
+bool WriteQueue::enqueue(const QBluetoothUuid &characteristic, const QByteArray &value, bool idempotent)
+{
+    // Only the newest queued write to the characteristic may be merged, anything else reorders commands
+    for (int i = m_queue.size() - 1; i >= 0; --i) {
+        Command &queued = m_queue[i];
+        if (queued.characteristic != characteristic)
+            continue;
+
+        const bool repeat = i == m_queue.size() - 1 && queued.value == value;
+        if (repeat || (idempotent && queued.idempotent)) {
+            queued.value = value;
+            m_stats.coalesced++;
+            return true;
+        }
+        break;
+    }
+
+    if (m_queue.size() >= m_maxDepth) {
+        m_stats.rejected++;
+        return false;
+    }
+
+    Command command;
+    command.characteristic = characteristic;
+    command.value = value;
+    command.queuedUs = now();
+    command.idempotent = idempotent;
+    m_queue.append(command);
+    m_stats.queued++;
+    m_busy = true;
+
+    pump();
+    return true;
+}
+
+void WriteQueue::clear()
+{
+    m_queue.clear();
+}
+
+int WriteQueue::depth() const
+{
+    return m_queue.size() + (m_awaitingResponse ? 1 : 0);
+}
+
+QList<QPair<QBluetoothUuid, QByteArray> > WriteQueue::pending() const
+{
+    QList<QPair<QBluetoothUuid, QByteArray> > values;
+    for (const Command &command : m_queue)
+        values.append(qMakePair(command.characteristic, command.value));
+    return values;
+}
+
+WriteQueue::Stats WriteQueue::stats() const
+{
+    return m_stats;
+}
+
+void WriteQueue::pump()
+{
+    if (!m_service || m_service->state() != QLowEnergyService::ServiceDiscovered)
+        return;
+
+    while (!m_queue.isEmpty() && !m_awaitingResponse) {
+        const QLowEnergyCharacteristic characteristic = m_service->characteristic(m_queue.first().characteristic);
+        if (!characteristic.isValid()) {
+            LOG_WARNING("Dropping write to unknown characteristic %1", m_queue.first().characteristic.toString());
+            m_queue.removeFirst();
+            m_stats.failed++;
+            continue;
+        }
+
+        if (characteristic.properties() & QLowEnergyCharacteristic::WriteNoResponse) {
+            if (m_credits == 0)
+                break;
+
+            m_credits--;
+            const Command command = m_queue.takeFirst();
+            m_service->writeCharacteristic(characteristic, command.value, QLowEnergyService::WriteWithoutResponse);
+            finished(command);
+        } else if (characteristic.properties() & QLowEnergyCharacteristic::Write) {
+            m_inFlight = m_queue.takeFirst();
+            m_awaitingResponse = true;
+            m_service->writeCharacteristic(characteristic, m_inFlight.value, QLowEnergyService::WriteWithResponse);
+        } else {
+            LOG_WARNING("Characteristic %1 is not writable", characteristic.uuid().toString());
+            m_queue.removeFirst();
+            m_stats.failed++;
+        }
+    }
+
+    // Credits only need refilling while something is spent or waiting
+    if (m_credits < m_maxCredits && !m_creditTimer.isActive())
+        m_creditTimer.start();
+
+    if (m_busy && m_queue.isEmpty() && !m_awaitingResponse) {
+        m_busy = false;
+        emit drained();
+    }
+}
+
+void WriteQueue::refillCredits()
+{
+    m_credits = m_maxCredits;
+    if (m_queue.isEmpty())
+        m_creditTimer.stop();
+
+    pump();
+}
+
+void WriteQueue::characteristicWritten(const QLowEnergyCharacteristic &characteristic, const QByteArray &value)
+{
+    Q_UNUSED(value);
+    if (!m_awaitingResponse || characteristic.uuid() != m_inFlight.characteristic)
+        return;
+
+    m_awaitingResponse = false;
+    finished(m_inFlight);
+    pump();
+}
+
+void WriteQueue::serviceError(QLowEnergyService::ServiceError error)
+{
+    if (error != QLowEnergyService::CharacteristicWriteError || !m_awaitingResponse)
+        return;
+
+    LOG_WARNING("Write to %1 failed", m_inFlight.characteristic.toString());
+    m_awaitingResponse = false;
+    m_stats.failed++;
+    pump();
+}
+
+void WriteQueue::finished(const Command &command)
+{
+    // Unacknowledged writes count until handed to the controller
+    const double latencyMs = (now() - command.queuedUs) / 1000.0;
+    m_stats.sent++;
+    m_stats.lastLatencyMs = latencyMs;
+    m_stats.averageLatencyMs += (latencyMs - m_stats.averageLatencyMs) / static_cast<double>(m_stats.sent);
+    emit commandWritten(command.characteristic, latencyMs);
+}
+
+qint64 WriteQueue::now() const
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
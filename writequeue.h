@@ -0,0 +1,87 @@
+#ifndef WRITEQUEUE_H
+#define WRITEQUEUE_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include <QtBluetooth/QLowEnergyService>
+#include <QtBluetooth/QBluetoothUuid>
+
+// Ordered command writes to the characteristics of one service. Characteristics
+// that allow it are written without response, limited to a number of credits per
+// connection interval so the notification stream keeps its share of the link.
+// Acknowledged writes go out one at a time.
+class WriteQueue : public QObject
+{
+    Q_OBJECT
+public:
+    struct Stats {
+        quint64 queued = 0;
+        quint64 sent = 0;
+        quint64 coalesced = 0;      // merged into a queued write before it went out
+        quint64 rejected = 0;       // queue was full
+        quint64 failed = 0;
+        double lastLatencyMs = 0.0;
+        double averageLatencyMs = 0.0;
+    };
+
+    WriteQueue(QObject *parent = nullptr);
+
+    // Service of the current connection, pending commands survive a reconnect
+    void setService(QLowEnergyService *service);
+    void setConnectionInterval(double intervalMs);
+    void setCredits(int creditsPerInterval);
+    void setMaxDepth(int maxDepth);
+
+    // False when the queue is full. Commands go out in enqueue order. A repeat of
+    // the last queued command is dropped, and an idempotent write (a setting
+    // where only the latest value matters) updates the still queued idempotent
+    // write to the same characteristic instead of queueing behind it.
+    bool enqueue(const QBluetoothUuid &characteristic, const QByteArray &value, bool idempotent = false);
+    void clear();
+
+    int depth() const;
+    // Queued values in send order, without the one waiting for its response
+    QList<QPair<QBluetoothUuid, QByteArray> > pending() const;
+    Stats stats() const;
+
+Q_SIGNALS:
+    void commandWritten(const QBluetoothUuid &characteristic, double latencyMs);
+    void drained();
+
+private slots:
+    void pump();
+    void refillCredits();
+    void characteristicWritten(const QLowEnergyCharacteristic &characteristic, const QByteArray &value);
+    void serviceError(QLowEnergyService::ServiceError error);
+
+private:
+    struct Command {
+        QBluetoothUuid characteristic;
+        QByteArray value;
+        qint64 queuedUs = 0;
+        bool idempotent = false;
+    };
+
+    void finished(const Command &command);
+    qint64 now() const;
+
+    QPointer<QLowEnergyService> m_service;
+    QList<Command> m_queue;
+    bool m_awaitingResponse = false;
+    bool m_busy = false;
+    Command m_inFlight;
+
+    int m_maxDepth = 32;
+    int m_maxCredits = 2;
+    int m_credits = 2;
+    QTimer m_creditTimer;
+    QElapsedTimer m_clock;
+
+    Stats m_stats;
+};
+
+#endif // WRITEQUEUE_H